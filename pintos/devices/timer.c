@@ -26,7 +26,12 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Wakes sleeping threads after each tick, outside the
+   interrupt handler proper. */
+static struct softirq timer_softirq;
+
 static intr_handler_func timer_interrupt;
+static softirq_func timer_wake_sleepers;
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
@@ -44,6 +49,7 @@ void timer_init(void)
 	outb(0x40, count & 0xff);
 	outb(0x40, count >> 8);
 
+	softirq_init(&timer_softirq, timer_wake_sleepers, NULL);
 	intr_register_ext(0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -125,8 +131,14 @@ void timer_print_stats(void)
 static void timer_interrupt(struct intr_frame *args UNUSED)
 {
 	ticks++;
-	wake_sleeping_threads(timer_ticks());
 	thread_tick();
+	softirq_raise(&timer_softirq);
+}
+
+/* Timer softirq. */
+static void timer_wake_sleepers(void *aux UNUSED)
+{
+	wake_sleeping_threads(timer_ticks());
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
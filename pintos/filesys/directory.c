@@ -5,8 +5,13 @@
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
-/* A directory. */
+/* A directory.
+
+   Lookups and readdir hold the directory inode's dir_lock for
+   reading, and adding or removing an entry holds it for writing,
+   so lookups in the same directory run in parallel. */
 struct dir {
 	struct inode *inode; /* Backing store. */
 	off_t pos;			 /* Current position. */
@@ -106,10 +111,13 @@ bool dir_lookup(const struct dir *dir, const char *name, struct inode **inode)
 	ASSERT(dir != NULL);
 	ASSERT(name != NULL);
 
+	/* Keep the entry from being removed until its inode is open. */
+	rwlock_acquire_read(inode_dir_lock(dir->inode));
 	if (lookup(dir, name, &e, NULL))
 		*inode = inode_open(e.inode_sector);
 	else
 		*inode = NULL;
+	rwlock_release_read(inode_dir_lock(dir->inode));
 
 	return *inode != NULL;
 }
@@ -133,6 +141,8 @@ bool dir_add(struct dir *dir, const char *name, disk_sector_t inode_sector)
 	if (*name == '\0' || strlen(name) > NAME_MAX)
 		return false;
 
+	rwlock_acquire_write(inode_dir_lock(dir->inode));
+
 	/* Check that NAME is not in use. */
 	if (lookup(dir, name, NULL, NULL))
 		goto done;
@@ -155,6 +165,7 @@ bool dir_add(struct dir *dir, const char *name, disk_sector_t inode_sector)
 	success = inode_write_at(dir->inode, &e, sizeof e, ofs) == sizeof e;
 
 done:
+	rwlock_release_write(inode_dir_lock(dir->inode));
 	return success;
 }
 
@@ -171,6 +182,8 @@ bool dir_remove(struct dir *dir, const char *name)
 	ASSERT(dir != NULL);
 	ASSERT(name != NULL);
 
+	rwlock_acquire_write(inode_dir_lock(dir->inode));
+
 	/* Find directory entry. */
 	if (!lookup(dir, name, &e, &ofs))
 		goto done;
@@ -190,6 +203,7 @@ bool dir_remove(struct dir *dir, const char *name)
 	success = true;
 
 done:
+	rwlock_release_write(inode_dir_lock(dir->inode));
 	inode_close(inode);
 	return success;
 }
@@ -200,13 +214,17 @@ done:
 bool dir_readdir(struct dir *dir, char name[NAME_MAX + 1])
 {
 	struct dir_entry e;
+	bool found = false;
 
+	rwlock_acquire_read(inode_dir_lock(dir->inode));
 	while (inode_read_at(dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
 		dir->pos += sizeof e;
 		if (e.in_use) {
 			strlcpy(name, e.name, NAME_MAX + 1);
-			return true;
+			found = true;
+			break;
 		}
 	}
-	return false;
+	rwlock_release_read(inode_dir_lock(dir->inode));
+	return found;
 }
@@ -6,6 +6,8 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -26,14 +28,34 @@ static inline size_t bytes_to_sectors(off_t size)
 	return DIV_ROUND_UP(size, DISK_SECTOR_SIZE);
 }
 
-/* In-memory inode. */
+/* In-memory inode.
+
+   `elem', `open_cnt' and `loading' are protected by
+   open_inodes_lock.  `lock' serializes writers of the inode's
+   data, so that the partial-sector read-modify-writes in
+   inode_write_at() do not interleave, and protects `removed' and
+   `deny_write_cnt'.  Readers take no lock: the length of a file
+   never changes, and each sector transfer is atomic.  `dir_lock'
+   is not used by this file; directory.c uses it to guard the
+   entries of a directory.
+
+   Lock order: an inode's `lock' comes before open_inodes_lock,
+   which is never held while waiting for another lock.
+   (inode_open() does take the `lock' of an inode it has just
+   allocated with open_inodes_lock held, but nobody else can hold
+   that lock yet.)  free_map_lock comes before the `lock' of the
+   free map file's inode, which bitmap_write() takes through
+   inode_write_at(). */
 struct inode {
 	struct list_elem elem;	/* Element in inode list. */
 	disk_sector_t sector;	/* Sector number of disk location. */
 	int open_cnt;			/* Number of openers. */
+	bool loading;			/* Still being read by inode_open(). */
 	bool removed;			/* True if deleted, false otherwise. */
 	int deny_write_cnt;		/* 0: writes ok, >0: deny writes. */
 	struct inode_disk data; /* Inode content. */
+	struct lock lock;		/* Data writers; removed, deny_write_cnt. */
+	struct rwlock dir_lock; /* Directory entries (directory.c). */
 };
 
 /* Returns the disk sector that contains byte offset POS within
@@ -52,11 +74,29 @@ static disk_sector_t byte_to_sector(const struct inode *inode, off_t pos)
 /* List of open inodes, so that opening a single inode twice
  * returns the same `struct inode'. */
 static struct list open_inodes;
+static struct lock open_inodes_lock;
+
+/* Cache of in-memory inodes.  Its constructor initializes the
+ * locks, which are always released by the time an inode is
+ * freed. */
+static struct kmem_cache inode_cache;
+static kmem_ctor_func inode_ctor;
 
 /* Initializes the inode module. */
 void inode_init(void)
 {
 	list_init(&open_inodes);
+	lock_init(&open_inodes_lock);
+	kmem_cache_init(&inode_cache, "inode", sizeof(struct inode), CACHE_LINE_SIZE, inode_ctor);
+}
+
+/* Constructs a cached inode. */
+static void inode_ctor(void *inode_)
+{
+	struct inode *inode = inode_;
+
+	lock_init(&inode->lock);
+	rwlock_init(&inode->dir_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -104,35 +144,63 @@ struct inode *inode_open(disk_sector_t sector)
 	struct list_elem *e;
 	struct inode *inode;
 
+	lock_acquire(&open_inodes_lock);
+
 	/* Check whether this inode is already open. */
 	for (e = list_begin(&open_inodes); e != list_end(&open_inodes); e = list_next(e)) {
 		inode = list_entry(e, struct inode, elem);
 		if (inode->sector == sector) {
-			inode_reopen(inode);
+			bool loading = inode->loading;
+
+			inode->open_cnt++;
+			lock_release(&open_inodes_lock);
+
+			/* Wait for the opener that is reading it, which holds
+			 * its lock until it is done. */
+			if (loading) {
+				lock_acquire(&inode->lock);
+				lock_release(&inode->lock);
+			}
 			return inode;
 		}
 	}
 
 	/* Allocate memory. */
-	inode = malloc(sizeof *inode);
-	if (inode == NULL)
+	inode = kmem_cache_alloc(&inode_cache);
+	if (inode == NULL) {
+		lock_release(&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
+	/* Initialize, and publish the inode as loading with its lock
+	 * held, so that the disk read below does not keep every other
+	 * open waiting and openers of the same inode wait for it. */
 	list_push_front(&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
+	inode->loading = true;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	lock_acquire(&inode->lock);
+	lock_release(&open_inodes_lock);
+
 	disk_read(filesys_disk, inode->sector, &inode->data);
+
+	lock_acquire(&open_inodes_lock);
+	inode->loading = false;
+	lock_release(&open_inodes_lock);
+	lock_release(&inode->lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *inode_reopen(struct inode *inode)
 {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire(&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release(&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -152,9 +220,11 @@ void inode_close(struct inode *inode)
 		return;
 
 	/* Release resources if this was the last opener. */
+	lock_acquire(&open_inodes_lock);
 	if (--inode->open_cnt == 0) {
 		/* Remove from inode list and release lock. */
 		list_remove(&inode->elem);
+		lock_release(&open_inodes_lock);
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -162,8 +232,9 @@ void inode_close(struct inode *inode)
 			free_map_release(inode->data.start, bytes_to_sectors(inode->data.length));
 		}
 
-		free(inode);
-	}
+		kmem_cache_free(&inode_cache, inode);
+	} else
+		lock_release(&open_inodes_lock);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -171,7 +242,9 @@ void inode_close(struct inode *inode)
 void inode_remove(struct inode *inode)
 {
 	ASSERT(inode != NULL);
+	lock_acquire(&inode->lock);
 	inode->removed = true;
+	lock_release(&inode->lock);
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
@@ -234,8 +307,11 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t
 	off_t bytes_written = 0;
 	uint8_t *bounce = NULL;
 
-	if (inode->deny_write_cnt)
+	lock_acquire(&inode->lock);
+	if (inode->deny_write_cnt) {
+		lock_release(&inode->lock);
 		return 0;
+	}
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
@@ -279,6 +355,7 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
+	lock_release(&inode->lock);
 	free(bounce);
 
 	return bytes_written;
@@ -288,8 +365,10 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t
    May be called at most once per inode opener. */
 void inode_deny_write(struct inode *inode)
 {
+	lock_acquire(&inode->lock);
 	inode->deny_write_cnt++;
 	ASSERT(inode->deny_write_cnt <= inode->open_cnt);
+	lock_release(&inode->lock);
 }
 
 /* Re-enables writes to INODE.
@@ -297,9 +376,11 @@ void inode_deny_write(struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void inode_allow_write(struct inode *inode)
 {
+	lock_acquire(&inode->lock);
 	ASSERT(inode->deny_write_cnt > 0);
 	ASSERT(inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	lock_release(&inode->lock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -307,3 +388,10 @@ off_t inode_length(const struct inode *inode)
 {
 	return inode->data.length;
 }
+
+/* Returns the lock that guards the entries of INODE, if it is a
+ * directory. */
+struct rwlock *inode_dir_lock(struct inode *inode)
+{
+	return &inode->dir_lock;
+}
@@ -119,6 +119,38 @@ __attribute__((always_inline)) static __inline uint64_t rcr2(void)
 	return val;
 }
 
+/* Executes CPUID for LEAF (subleaf 0) and stores the results in
+   *EAX, *EBX, *ECX, *EDX. */
+__attribute__((always_inline)) static __inline void cpuid(uint32_t leaf, uint32_t *eax,
+														 uint32_t *ebx, uint32_t *ecx,
+														 uint32_t *edx)
+{
+	__asm __volatile("cpuid"
+					 : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+					 : "a"(leaf), "c"(0));
+}
+
+/* Returns true if the CPU supports 1 GiB pages.  See [IA32-v2a]
+   "CPUID", extended function 80000001h, EDX bit 26. */
+__attribute__((always_inline)) static __inline bool cpu_has_huge_pages(void)
+{
+	uint32_t eax, ebx, ecx, edx;
+
+	cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+	if (eax < 0x80000001)
+		return false;
+	cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+	return (edx & (1u << 26)) != 0;
+}
+
+/* Reads the processor's time-stamp counter. */
+__attribute__((always_inline)) static __inline uint64_t rdtsc(void)
+{
+	uint32_t lo, hi;
+	__asm __volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
 __attribute__((always_inline)) static __inline void write_msr(uint32_t ecx, uint64_t val)
 {
 	uint32_t edx, eax;
@@ -0,0 +1,19 @@
+#ifndef __LIB_FUTEX_H
+#define __LIB_FUTEX_H
+
+/* Operations for the SYS_FUTEX system call.
+
+   A futex is an aligned int in user memory.  FUTEX_WAIT blocks
+   the caller as long as the int still holds the expected value,
+   and FUTEX_WAKE wakes up to a given number of threads blocked on
+   the same int, in this process or in any other that shares the
+   page holding it, such as a page fork() left shared because
+   neither side has written it since.  FUTEX_WAIT may also return
+   without a matching FUTEX_WAKE.  Everything else, including the
+   uncontended fast path, is left to user space. */
+enum futex_op {
+	FUTEX_WAIT, /* Sleep if *ADDR == VAL. */
+	FUTEX_WAKE, /* Wake up to VAL waiters on ADDR. */
+};
+
+#endif /* lib/futex.h */
@@ -0,0 +1,67 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+ *
+ * This is a pairing heap.  Like the doubly linked list in
+ * list.h, it does not require dynamically allocated memory:
+ * each structure that is a potential heap element must embed a
+ * struct heap_elem member, and heap_entry() converts a struct
+ * heap_elem back to the structure that contains it.  Because no
+ * memory is allocated, all of the operations may be called with
+ * interrupts disabled or from an interrupt handler.
+ *
+ * The heap is ordered by a caller-supplied "less" function.  The
+ * top of the heap is an element that no other element is less
+ * than, so a min-heap on KEY uses `a->key < b->key' and a
+ * max-heap uses `a->key > b->key'.
+ *
+ * Costs: heap_push(), heap_top(), heap_empty(), heap_size() are
+ * O(1).  heap_pop(), heap_remove(), and heap_update() are
+ * O(log n) amortized. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child; /* Leftmost child. */
+	struct heap_elem *next;	 /* Next sibling. */
+	struct heap_elem *prev;	 /* Previous sibling, or parent if leftmost child. */
+};
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A belongs closer to the
+   top of the heap than B. */
+typedef bool heap_less_func(const struct heap_elem *a, const struct heap_elem *b, void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root; /* Top element, or null if empty. */
+	size_t elem_cnt;		/* Number of elements in heap. */
+	heap_less_func *less;	/* Comparison function. */
+	void *aux;				/* Auxiliary data for `less'. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)                                                      \
+	((STRUCT *)((uint8_t *)&(HEAP_ELEM)->next - offsetof(STRUCT, MEMBER.next)))
+
+void heap_init(struct heap *, heap_less_func *, void *aux);
+
+/* Insertion and removal. */
+void heap_push(struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop(struct heap *);
+void heap_remove(struct heap *, struct heap_elem *);
+void heap_update(struct heap *, struct heap_elem *);
+
+/* Heap properties. */
+struct heap_elem *heap_top(const struct heap *);
+size_t heap_size(const struct heap *);
+bool heap_empty(const struct heap *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,23 @@
+#ifndef __LIB_KERNEL_LZ_H
+#define __LIB_KERNEL_LZ_H
+
+/* LZ77 compression.
+ *
+ * The format is that of LZF: a stream of literal runs of 1 to 32
+ * bytes and back references of 3 to 264 bytes reaching up to 8 kB
+ * behind.  Compression is a single greedy pass with a small hash
+ * table of recent positions, so it is fast rather than tight,
+ * and decompression is a simple copy loop.  Neither allocates
+ * memory; the compressor's hash table lives in a caller-supplied
+ * workspace of LZ_WORK_SIZE bytes. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LZ_HASH_BITS 12
+#define LZ_WORK_SIZE ((1 << LZ_HASH_BITS) * sizeof(uint16_t))
+
+size_t lz_compress(const void *src, size_t src_len, void *dst, size_t dst_cap, void *work);
+size_t lz_decompress(const void *src, size_t src_len, void *dst, size_t dst_cap);
+
+#endif /* lib/kernel/lz.h */
@@ -0,0 +1,37 @@
+#ifndef __LIB_SCHED_STATS_H
+#define __LIB_SCHED_STATS_H
+
+#include <stdint.h>
+
+/* Scheduling-latency statistics, kept by the scheduler per thread
+   and system-wide, and handed to user programs by the
+   SYS_SCHED_STATS system call. */
+
+/* Histograms are over TSC cycles >> SCHED_HIST_SHIFT.  Bucket 0
+   counts samples under one unit, bucket I counts samples in
+   [2^(I-1), 2^I) units, and the last bucket also absorbs
+   everything larger. */
+#define SCHED_HIST_SHIFT 10
+#define SCHED_HIST_BUCKETS 20
+
+/* Log2 histogram. */
+struct sched_hist {
+	uint32_t count[SCHED_HIST_BUCKETS];
+};
+
+struct sched_stats {
+	struct sched_hist run_wait; /* Time spent ready before dispatch. */
+	struct sched_hist wakeup;	/* Time from thread_unblock() to dispatch. */
+	struct sched_hist slice;	/* CPU time used per dispatch. */
+	uint64_t voluntary;			/* Switches away by blocking or exiting. */
+	uint64_t involuntary;		/* Switches away by preemption. */
+	uint64_t deadline_misses;	/* Real-time periods that ended unfinished. */
+};
+
+/* Whose statistics SYS_SCHED_STATS returns. */
+enum sched_stats_scope {
+	SCHED_STATS_SELF,	/* The calling thread. */
+	SCHED_STATS_SYSTEM, /* All threads since boot. */
+};
+
+#endif /* lib/sched-stats.h */
@@ -36,6 +36,13 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra: scheduler statistics. */
+	SYS_SCHED_STATS, /* Read scheduling-latency statistics. */
+	SYS_SET_DEADLINE, /* Join or leave the real-time class. */
+
+	/* Extra: user-space synchronization. */
+	SYS_FUTEX, /* Wait or wake on a user address. */
 };
 
 #endif /* lib/syscall-nr.h */
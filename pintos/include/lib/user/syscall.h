@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <futex.h>
+#include <sched-stats.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -38,6 +40,13 @@ void close(int fd);
 
 int dup2(int oldfd, int newfd);
 
+/* Extra: scheduler statistics. */
+bool get_sched_stats(enum sched_stats_scope scope, struct sched_stats *stats);
+bool set_deadline(int64_t period, int64_t budget);
+
+/* Extra: user-space synchronization. */
+int futex(int *uaddr, enum futex_op op, int val);
+
 /* Project 3 and optionally project 4. */
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void *addr);
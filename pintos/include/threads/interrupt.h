@@ -1,6 +1,7 @@
 #ifndef THREADS_INTERRUPT_H
 #define THREADS_INTERRUPT_H
 
+#include <list.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -72,6 +73,28 @@ void intr_register_int(uint8_t vec, int dpl, enum intr_level, intr_handler_func
 bool intr_context(void);
 void intr_yield_on_return(void);
 
+/* Deferred interrupt work.
+
+   An interrupt handler that has more to do than it should do
+   with interrupts off raises a softirq instead.  Raised softirqs
+   run just before the outermost external interrupt returns, on
+   the interrupted thread, with interrupts enabled.  Like
+   interrupt handlers they may not sleep, and may only touch data
+   that is protected by disabling interrupts, but they may invoke
+   intr_yield_on_return(). */
+typedef void softirq_func(void *aux);
+
+struct softirq {
+	struct list_elem elem; /* Element in the pending list. */
+	bool pending;		   /* Raised but not yet run? */
+	softirq_func *func;	   /* Function to run. */
+	void *aux;			   /* Argument to FUNC. */
+};
+
+void softirq_init(struct softirq *, softirq_func *, void *aux);
+void softirq_raise(struct softirq *);
+bool softirq_context(void);
+
 void intr_dump_frame(const struct intr_frame *);
 const char *intr_name(uint8_t vec);
 
@@ -14,6 +14,7 @@ void pml4_destroy(uint64_t *pml4);
 void pml4_activate(uint64_t *pml4);
 void *pml4_get_page(uint64_t *pml4, const void *upage);
 bool pml4_set_page(uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_set_large_page(uint64_t *pml4, void *va, uint64_t pa, uint64_t size, int perm);
 void pml4_clear_page(uint64_t *pml4, void *upage);
 bool pml4_is_dirty(uint64_t *pml4, const void *upage);
 void pml4_set_dirty(uint64_t *pml4, const void *upage, bool dirty);
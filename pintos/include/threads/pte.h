@@ -41,5 +41,11 @@
 #define PTE_U 0x4							/* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20							/* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40							/* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80							/* 1=large page (PDPEs and PDEs only). */
+
+/* Sizes of the pages that a PDE or a PDPE with PTE_PS set maps.
+   The latter needs CPU support (see cpu_has_huge_pages()). */
+#define LARGE_PAGE_SIZE (1UL << PDXSHIFT) /* 2 MiB. */
+#define HUGE_PAGE_SIZE (1UL << PDPESHIFT) /* 1 GiB. */
 
 #endif /* threads/pte.h */
@@ -0,0 +1,38 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* Size of a CPU cache line, for kmem_cache_init()'s ALIGN. */
+#define CACHE_LINE_SIZE 64
+
+/* Object constructor.  Runs once on each object when the slab
+   holding it is created, not on every allocation, so objects
+   must be returned to the cache in their constructed state. */
+typedef void kmem_ctor_func(void *obj);
+
+/* Cache of objects of a single type, carved out of whole pages
+   ("slabs") in slots of exactly the object size rounded up to
+   the alignment.  See slab.c for details. */
+struct kmem_cache {
+	const char *name;	   /* Name, for debugging. */
+	size_t obj_size;	   /* Object size as requested. */
+	size_t slot_size;	   /* Object size rounded up to alignment. */
+	size_t slot_ofs;	   /* Offset of the first slot in a slab. */
+	size_t slots_per_slab; /* Number of slots in a slab. */
+	kmem_ctor_func *ctor;  /* Constructor, or null. */
+	struct list partial;   /* Slabs that have free slots. */
+	struct lock lock;	   /* Mutual exclusion. */
+	size_t slab_cnt;	   /* Number of slabs. */
+	size_t obj_cnt;		   /* Number of allocated objects. */
+};
+
+void kmem_cache_init(struct kmem_cache *, const char *name, size_t size, size_t align,
+					 kmem_ctor_func *);
+void *kmem_cache_alloc(struct kmem_cache *);
+void *kmem_cache_zalloc(struct kmem_cache *);
+void kmem_cache_free(struct kmem_cache *, void *);
+
+#endif /* threads/slab.h */
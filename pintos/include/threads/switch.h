@@ -0,0 +1,34 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#include <stdint.h>
+
+/* Kernel-to-kernel context switch.
+ *
+ * schedule() always runs in kernel mode with interrupts off, so
+ * switching threads only has to preserve what the System V ABI
+ * says a function call preserves: the callee-saved registers and
+ * the stack pointer.  switch_threads() pushes those on the
+ * current thread's kernel stack, saves rsp in *CUR_RSP, then
+ * loads NEXT_RSP and pops the next thread's registers from its
+ * stack.  The `ret' at the end resumes the next thread wherever
+ * it last called switch_threads().
+ *
+ * A thread that has never run has no such frame yet, so
+ * thread_create() builds one by hand whose return address leads
+ * to the full intr_frame/iretq launch. */
+
+/* Stack frame of switch_threads(), lowest address first. */
+struct switch_threads_frame {
+	uint64_t r15;
+	uint64_t r14;
+	uint64_t r13;
+	uint64_t r12;
+	uint64_t rbx;
+	uint64_t rbp;
+	void (*rip)(void); /* Return address. */
+};
+
+void switch_threads(uintptr_t *cur_rsp, uintptr_t next_rsp);
+
+#endif /* threads/switch.h */
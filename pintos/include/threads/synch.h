@@ -1,6 +1,7 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
 
@@ -20,14 +21,35 @@ void sema_self_test(void);
 struct lock {
 	struct thread *holder;		/* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+
+	/* Priority donation. */
+	struct heap waiters;		  /* Waiting threads, highest priority on top. */
+	struct heap_elem holder_elem; /* Element in holder's held_locks. */
 };
 
 void lock_init(struct lock *);
+void lock_init_holder(struct thread *);
+int lock_donated_priority(const struct thread *);
 void lock_acquire(struct lock *);
 bool lock_try_acquire(struct lock *);
 void lock_release(struct lock *);
 bool lock_held_by_current_thread(const struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock {
+	struct lock writer;		  /* Held by the writer, and briefly by readers. */
+	unsigned readers;		  /* # of threads holding read access. */
+	bool draining;			  /* Writer waiting for readers to leave? */
+	struct semaphore drained; /* Upped when the last reader leaves. */
+};
+
+void rwlock_init(struct rwlock *);
+void rwlock_acquire_read(struct rwlock *);
+void rwlock_release_read(struct rwlock *);
+void rwlock_acquire_write(struct rwlock *);
+void rwlock_release_write(struct rwlock *);
+bool rwlock_held_for_write(const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
 	struct list waiters; /* List of waiting threads. */
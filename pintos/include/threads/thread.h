@@ -2,7 +2,9 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
+#include <sched-stats.h>
 #include <stdint.h>
 
 #include "synch.h"
@@ -94,18 +96,38 @@ struct thread {
 	char name[16];			   /* Name (for debugging purposes). */
 	int priority;			   /* Priority. */
 
-	int base_priority;
-	struct lock *waiting_lock;
-	struct list donor_list;
-	struct list_elem donor_elem;
+	/* Priority donation (synch.c). */
+	int base_priority;			 /* Priority before donation. */
+	struct lock *waiting_lock;	 /* Lock being waited for, if any. */
+	struct heap held_locks;		 /* Locks held, by top waiter's priority. */
+	struct heap_elem donor_elem; /* Element in waiting_lock's waiters. */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem; /* List element. */
 	struct list_elem allelem;
-	int64_t wakeup_tick;
+	struct list_elem tid_elem; /* Element in tid table (thread.c). */
+	int64_t wakeup_tick;		  /* Tick to wake up at, if sleeping. */
+	struct heap_elem sleep_elem; /* Element in sleep heap (thread.c). */
 
 	int nice;
 	fixed_t recent_cpu;
+	int64_t recent_cpu_sec; /* Second recent_cpu was last decayed at (MLFQS). */
+	int64_t vruntime;			/* Weighted CPU time (fair scheduler). */
+	struct heap_elem fair_elem; /* Element in run queue (fair scheduler). */
+
+	/* Real-time (EDF) class, if rt_period != 0.  Times in ticks. */
+	int64_t rt_period;		  /* Length of a period. */
+	int64_t rt_budget;		  /* CPU time allowed per period. */
+	int64_t rt_deadline;	  /* End of the current period. */
+	int64_t rt_runtime;		  /* Budget left in the current period. */
+	bool rt_throttled;		  /* Out of budget until rt_deadline? */
+	struct heap_elem rt_elem; /* Element in run queue. */
+
+	/* Scheduling-latency accounting (thread.c). */
+	struct sched_stats sched_stats; /* This thread's histograms. */
+	uint64_t sched_enqueued;		/* TSC when it last became ready. */
+	uint64_t sched_dispatched;		/* TSC when last given the CPU. */
+	bool sched_woken;				/* Enqueued by thread_unblock()? */
 
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
@@ -125,15 +147,18 @@ struct thread {
 #endif
 
 	/* Owned by thread.c. */
-	struct intr_frame tf; /* Information for switching */
+	struct intr_frame tf; /* Information for first launch */
+	uintptr_t switch_rsp; /* Saved stack pointer (switch.h) */
 	unsigned magic;		  /* Detects stack overflow. */
 };
 
 struct child_info {
 	tid_t tid;
+	tid_t parent_tid;
 	int exit_status;
 	bool wait;
 	struct list_elem child_elem;
+	struct list_elem tid_elem; /* Element in child table (thread.c). */
 	struct semaphore wait_sema;
 };
 
@@ -142,6 +167,10 @@ struct child_info {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler instead.
+   Controlled by kernel command-line option "-o fair". */
+extern bool thread_fair;
+
 void thread_init(void);
 void thread_start(void);
 
@@ -156,6 +185,11 @@ void thread_unblock(struct thread *);
 
 struct thread *thread_current(void);
 tid_t thread_tid(void);
+struct thread *thread_lookup(tid_t);
+#ifdef USERPROG
+struct child_info *thread_find_child(tid_t);
+void thread_reap_child(struct child_info *);
+#endif
 const char *thread_name(void);
 
 void thread_exit(void) NO_RETURN;
@@ -166,11 +200,15 @@ void wake_sleeping_threads(int64_t tick);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
+void thread_update_priority(struct thread *, int priority);
 int thread_get_nice(void);
 void thread_set_nice(int);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
 
+bool thread_get_sched_stats(enum sched_stats_scope, struct sched_stats *);
+bool thread_set_deadline(int64_t period, int64_t budget);
+
 void do_iret(struct intr_frame *tf);
 
 bool thread_priority_max(const struct list_elem *e1, const struct list_elem *e2, void *aux);
@@ -3,12 +3,15 @@
 #include "vm/vm.h"
 struct page;
 enum vm_type;
+struct zswap_entry;
 
 struct anon_page {
     int swap_table_index;
+    struct zswap_entry *zswap; /* Compressed copy, if in the zswap cache. */
 };
 
 void vm_anon_init(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+bool anon_swap_write(struct page *page, const void *kva);
 
 #endif
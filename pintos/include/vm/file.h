@@ -23,6 +23,8 @@ struct mmap_aux {
 };
 
 void vm_file_init(void);
+struct mmap_aux *mmap_aux_alloc(void);
+void mmap_aux_free(struct mmap_aux *aux);
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset);
 void do_munmap(void *va);
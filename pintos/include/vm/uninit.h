@@ -23,6 +23,9 @@ struct vm_load_aux {
 	uint32_t page_read_bytes; // 페이지에서 읽어야 하는 바이트의 개수
 };
 
+void vm_uninit_init(void);
+struct vm_load_aux *vm_load_aux_alloc(void);
+void vm_load_aux_free(struct vm_load_aux *aux);
 void uninit_new(struct page *page, void *va, vm_initializer *init, enum vm_type type, void *aux,
 				bool (*initializer)(struct page *, enum vm_type, void *kva));
 #endif
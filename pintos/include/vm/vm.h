@@ -50,6 +50,7 @@ struct page {
 	struct hash_elem spt_hash_elem;
 	bool writable;
 	struct thread *owner_thread;
+	struct list_elem mapping_elem; /* Element in frame's pages list. */
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -63,10 +64,13 @@ struct page {
 	};
 };
 
-/* The representation of "frame" */
+/* The representation of "frame".
+ * After fork() a frame may be mapped read-only by the same page of
+ * several processes until one of them writes to it (copy-on-write). */
 struct frame {
 	void *kva;
-	struct page *page;
+	struct list pages; /* Pages mapping this frame, through mapping_elem. */
+	unsigned ref_cnt;  /* Number of pages in PAGES. */
 	struct list_elem frame_elem;
 };
 
@@ -111,6 +115,8 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writable,
 									vm_initializer *init, void *aux);
 void vm_dealloc_page(struct page *page);
+void vm_release_frame(struct page *page);
+void vm_print_stats(void);
 bool vm_claim_page(void *va);
 enum vm_type page_get_type(struct page *page);
 
@@ -0,0 +1,18 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+struct zswap_entry;
+
+/* Most pages of memory the compressed cache may use. */
+extern size_t zswap_page_limit;
+
+void zswap_init(void);
+bool zswap_store(struct page *page, const void *kva);
+bool zswap_load(struct page *page, void *kva);
+size_t zswap_invalidate(struct page *page);
+void zswap_print_stats(void);
+
+#endif
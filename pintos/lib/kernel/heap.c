@@ -0,0 +1,184 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* Pairing heap.
+
+   Each element keeps a pointer to its leftmost child and to its
+   neighbouring siblings, so the children of an element form a
+   doubly linked list whose first member points back to the
+   parent through `prev'.  The root has no siblings and a null
+   `prev'.
+
+   Two heaps are merged by "linking" their roots: the root that
+   is not less than the other becomes the leftmost child of the
+   other.  Popping the root leaves a list of subheaps, which are
+   merged back together with the standard two-pass scheme: link
+   them in pairs from left to right, then link the pairs from
+   right to left. */
+
+static struct heap_elem *link(struct heap *, struct heap_elem *a, struct heap_elem *b);
+static struct heap_elem *merge_pairs(struct heap *, struct heap_elem *first);
+static void detach(struct heap_elem *);
+
+/* Initializes H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void heap_init(struct heap *h, heap_less_func *less, void *aux)
+{
+	ASSERT(h != NULL);
+	ASSERT(less != NULL);
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts ELEM into H. */
+void heap_push(struct heap *h, struct heap_elem *elem)
+{
+	ASSERT(h != NULL);
+	ASSERT(elem != NULL);
+
+	elem->child = elem->next = elem->prev = NULL;
+	h->root = h->root != NULL ? link(h, h->root, elem) : elem;
+	h->elem_cnt++;
+}
+
+/* Removes and returns the top element of H, which must not be
+   empty. */
+struct heap_elem *heap_pop(struct heap *h)
+{
+	struct heap_elem *top;
+
+	ASSERT(h != NULL);
+	ASSERT(h->root != NULL);
+
+	top = h->root;
+	h->root = merge_pairs(h, top->child);
+	h->elem_cnt--;
+	top->child = NULL;
+	return top;
+}
+
+/* Removes ELEM, which must be in H, from H. */
+void heap_remove(struct heap *h, struct heap_elem *elem)
+{
+	struct heap_elem *sub;
+
+	ASSERT(h != NULL);
+	ASSERT(elem != NULL);
+
+	if (elem == h->root) {
+		heap_pop(h);
+		return;
+	}
+
+	detach(elem);
+	sub = merge_pairs(h, elem->child);
+	if (sub != NULL)
+		h->root = link(h, h->root, sub);
+	h->elem_cnt--;
+	elem->child = NULL;
+}
+
+/* Restores the heap property after the key of ELEM, which must
+   be in H, has changed. */
+void heap_update(struct heap *h, struct heap_elem *elem)
+{
+	heap_remove(h, elem);
+	heap_push(h, elem);
+}
+
+/* Returns the top element of H, or a null pointer if H is
+   empty. */
+struct heap_elem *heap_top(const struct heap *h)
+{
+	ASSERT(h != NULL);
+	return h->root;
+}
+
+/* Returns the number of elements in H. */
+size_t heap_size(const struct heap *h)
+{
+	ASSERT(h != NULL);
+	return h->elem_cnt;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool heap_empty(const struct heap *h)
+{
+	ASSERT(h != NULL);
+	return h->root == NULL;
+}
+
+/* Links roots A and B, neither of which may have siblings, and
+   returns the root of the combined heap.  A stays on top unless
+   B is less than A. */
+static struct heap_elem *link(struct heap *h, struct heap_elem *a, struct heap_elem *b)
+{
+	struct heap_elem *parent, *child;
+
+	if (h->less(b, a, h->aux)) {
+		parent = b;
+		child = a;
+	} else {
+		parent = a;
+		child = b;
+	}
+
+	child->prev = parent;
+	child->next = parent->child;
+	if (parent->child != NULL)
+		parent->child->prev = child;
+	parent->child = child;
+	parent->next = parent->prev = NULL;
+	return parent;
+}
+
+/* Merges the sibling list starting at FIRST into a single heap
+   and returns its root, or a null pointer if FIRST is null. */
+static struct heap_elem *merge_pairs(struct heap *h, struct heap_elem *first)
+{
+	struct heap_elem *pairs = NULL; /* Linked through `next', rightmost first. */
+	struct heap_elem *root = NULL;
+
+	/* First pass: link siblings in pairs, left to right. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL) {
+			b->next = b->prev = NULL;
+			a = link(h, a, b);
+		}
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* Second pass: link the pairs, right to left. */
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		root = root != NULL ? link(h, pairs, root) : pairs;
+		pairs = next;
+	}
+	return root;
+}
+
+/* Unlinks non-root ELEM from its parent's list of children.
+   ELEM keeps its own children. */
+static void detach(struct heap_elem *elem)
+{
+	ASSERT(elem->prev != NULL);
+
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->next;
+	else
+		elem->prev->next = elem->next;
+	if (elem->next != NULL)
+		elem->next->prev = elem->prev;
+	elem->next = elem->prev = NULL;
+}
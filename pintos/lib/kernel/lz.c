@@ -0,0 +1,136 @@
+#include "lz.h"
+#include <stdbool.h>
+#include <string.h>
+#include "../debug.h"
+
+/* Each control byte C either starts a literal run, if C < 32, of
+   C + 1 bytes that follow it, or a back reference.  For a back
+   reference, the top 3 bits of C are the length minus 2, with 7
+   meaning that the next byte holds the rest of the length, and
+   the low 5 bits with the byte after that form the distance back
+   minus 1. */
+
+#define MAX_LIT 32					/* Longest literal run. */
+#define MAX_OFF (1 << 13)			/* Farthest back reference. */
+#define MAX_REF (2 + 7 + UINT8_MAX) /* Longest back reference. */
+
+static bool emit_literals(uint8_t **op, uint8_t *oend, const uint8_t *lit, const uint8_t *end);
+
+/* Returns the hash of the 3 bytes at P. */
+static inline unsigned hash3(const uint8_t *p)
+{
+	uint32_t v = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Compresses the SRC_LEN bytes at SRC, which may be at most 64 kB,
+   into DST, which has room for DST_CAP bytes, using the
+   LZ_WORK_SIZE bytes at WORK as scratch space.  Returns the size
+   of the compressed data, or 0 if it does not fit in DST_CAP
+   bytes. */
+size_t lz_compress(const void *src_, size_t src_len, void *dst_, size_t dst_cap, void *work)
+{
+	const uint8_t *src = src_;
+	const uint8_t *ip = src, *lit = src, *end = src + src_len;
+	uint8_t *op = dst_, *oend = op + dst_cap;
+	uint16_t *table = work;
+
+	ASSERT(src_len <= UINT16_MAX + 1);
+
+	memset(table, 0, LZ_WORK_SIZE);
+	while (end - ip >= 3) {
+		unsigned h = hash3(ip);
+		const uint8_t *ref = src + table[h];
+		size_t off = ip - ref;
+
+		table[h] = ip - src;
+		if (ref < ip && off <= MAX_OFF && ref[0] == ip[0] && ref[1] == ip[1] &&
+			ref[2] == ip[2]) {
+			size_t max = (size_t)(end - ip) < MAX_REF ? (size_t)(end - ip) : MAX_REF;
+			size_t len = 3;
+
+			while (len < max && ref[len] == ip[len])
+				len++;
+
+			if (!emit_literals(&op, oend, lit, ip) || oend - op < 3)
+				return 0;
+			if (len - 2 < 7)
+				*op++ = (len - 2) << 5 | (off - 1) >> 8;
+			else {
+				*op++ = 7 << 5 | (off - 1) >> 8;
+				*op++ = len - 2 - 7;
+			}
+			*op++ = (off - 1) & 0xff;
+
+			ip += len;
+			lit = ip;
+		} else
+			ip++;
+	}
+	if (!emit_literals(&op, oend, lit, end))
+		return 0;
+	return op - (uint8_t *)dst_;
+}
+
+/* Decompresses the SRC_LEN bytes at SRC, which lz_compress()
+   produced, into DST, which has room for DST_CAP bytes.  Returns
+   the size of the decompressed data, or 0 if SRC is corrupt or
+   does not fit in DST_CAP bytes. */
+size_t lz_decompress(const void *src, size_t src_len, void *dst_, size_t dst_cap)
+{
+	const uint8_t *ip = src, *iend = ip + src_len;
+	uint8_t *dst = dst_, *op = dst, *oend = dst + dst_cap;
+
+	while (ip < iend) {
+		unsigned c = *ip++;
+
+		if (c < MAX_LIT) {
+			size_t len = c + 1;
+
+			if ((size_t)(iend - ip) < len || (size_t)(oend - op) < len)
+				return 0;
+			memcpy(op, ip, len);
+			ip += len;
+			op += len;
+		} else {
+			size_t len = c >> 5;
+			const uint8_t *ref;
+
+			if (len == 7) {
+				if (ip >= iend)
+					return 0;
+				len += *ip++;
+			}
+			if (ip >= iend)
+				return 0;
+			ref = op - ((c & 0x1f) << 8 | *ip++) - 1;
+			len += 2;
+			if (ref < dst || (size_t)(oend - op) < len)
+				return 0;
+
+			/* Byte by byte, since the source may overlap the
+			   destination. */
+			while (len-- > 0)
+				*op++ = *ref++;
+		}
+	}
+	return op - dst;
+}
+
+/* Appends the bytes between LIT and END to *OP as literal runs,
+   without going past OEND.  Returns false if they do not fit. */
+static bool emit_literals(uint8_t **op, uint8_t *oend, const uint8_t *lit, const uint8_t *end)
+{
+	while (lit < end) {
+		size_t len = end - lit < MAX_LIT ? (size_t)(end - lit) : MAX_LIT;
+
+		if ((size_t)(oend - *op) < len + 1)
+			return false;
+		*(*op)++ = len - 1;
+		memcpy(*op, lit, len);
+		*op += len;
+		lit += len;
+	}
+	return true;
+}
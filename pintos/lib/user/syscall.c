@@ -129,6 +129,21 @@ int dup2(int oldfd, int newfd)
 	return syscall2(SYS_DUP2, oldfd, newfd);
 }
 
+bool get_sched_stats(enum sched_stats_scope scope, struct sched_stats *stats)
+{
+	return syscall2(SYS_SCHED_STATS, scope, stats);
+}
+
+bool set_deadline(int64_t period, int64_t budget)
+{
+	return syscall2(SYS_SET_DEADLINE, period, budget);
+}
+
+int futex(int *uaddr, enum futex_op op, int val)
+{
+	return syscall3(SYS_FUTEX, uaddr, op, val);
+}
+
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 {
 	return (void *)syscall5(SYS_MMAP, addr, length, writable, fd, offset);
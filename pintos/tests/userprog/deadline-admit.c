@@ -0,0 +1,37 @@
+/* Checks that set_deadline() admits reservations that fit and
+   rejects invalid ones and ones that would overcommit the CPU,
+   including across processes. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int pid;
+
+  CHECK (!set_deadline (-1, 0), "negative period rejected");
+  CHECK (!set_deadline (10, 0), "empty budget rejected");
+  CHECK (!set_deadline (10, 11), "budget longer than period rejected");
+  CHECK (!set_deadline (INT64_MAX, INT64_MAX / 2), "huge period rejected");
+  CHECK (!set_deadline (10, 10), "full utilization rejected");
+  CHECK (set_deadline (100, 60), "60%% utilization admitted");
+  CHECK (set_deadline (100, 90), "own reservation replaced");
+
+  if ((pid = fork ("child")) == 0)
+    {
+      CHECK (!set_deadline (100, 10), "child overcommit rejected");
+      exit (0);
+    }
+  CHECK (wait (pid) == 0, "wait for child");
+
+  CHECK (set_deadline (0, 0), "reservation dropped");
+  if ((pid = fork ("child")) == 0)
+    {
+      CHECK (set_deadline (100, 10), "child admitted");
+      exit (0);
+    }
+  CHECK (wait (pid) == 0, "wait for child");
+}
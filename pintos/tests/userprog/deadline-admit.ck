@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(deadline-admit) begin
+(deadline-admit) negative period rejected
+(deadline-admit) empty budget rejected
+(deadline-admit) budget longer than period rejected
+(deadline-admit) huge period rejected
+(deadline-admit) full utilization rejected
+(deadline-admit) 60% utilization admitted
+(deadline-admit) own reservation replaced
+(deadline-admit) child overcommit rejected
+child: exit(0)
+(deadline-admit) wait for child
+(deadline-admit) reservation dropped
+(deadline-admit) child admitted
+child: exit(0)
+(deadline-admit) wait for child
+(deadline-admit) end
+deadline-admit: exit(0)
+EOF
+pass;
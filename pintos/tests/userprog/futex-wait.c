@@ -0,0 +1,21 @@
+/* Checks the cases in which the futex system call returns
+   without blocking: FUTEX_WAIT on a word that no longer holds
+   the expected value or on a misaligned address, and FUTEX_WAKE
+   with nobody waiting. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int words[2];
+
+void
+test_main (void) 
+{
+  words[0] = 1;
+  CHECK (futex (&words[0], FUTEX_WAIT, 0) == -1, "wait on changed word");
+  CHECK (futex ((int *) ((char *) &words[0] + 1), FUTEX_WAIT, 0) == -1,
+         "wait on misaligned word");
+  CHECK (futex (&words[0], FUTEX_WAKE, 1) == 0, "wake with no waiters");
+  CHECK (futex (&words[1], FUTEX_WAKE, 1) == 0, "wake another word");
+}
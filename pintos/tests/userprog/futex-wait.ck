@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-wait) begin
+(futex-wait) wait on changed word
+(futex-wait) wait on misaligned word
+(futex-wait) wake with no waiters
+(futex-wait) wake another word
+(futex-wait) end
+futex-wait: exit(0)
+EOF
+pass;
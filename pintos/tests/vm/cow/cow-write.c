@@ -0,0 +1,46 @@
+/* Forks with several pages of data shared copy-on-write, lets
+   the child overwrite all of them and checks that the parent
+   still sees its own data, both while the child is alive and
+   after it has exited. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 8
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+	pid_t child;
+	size_t i;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		memset (buf + i * PAGE_SIZE, 'a' + i, PAGE_SIZE);
+
+	child = fork ("child");
+	if (child == 0) {
+		for (i = 0; i < PAGE_CNT; i++)
+			memset (buf + i * PAGE_SIZE, 'z', PAGE_SIZE);
+		for (i = 0; i < PAGE_CNT * PAGE_SIZE; i++)
+			if (buf[i] != 'z')
+				fail ("child lost its write at offset %zu", i);
+		msg ("child wrote every page");
+		exit (0);
+	}
+
+	CHECK (wait (child) == 0, "wait for child");
+	for (i = 0; i < PAGE_CNT * PAGE_SIZE; i++)
+		if (buf[i] != (char) ('a' + i / PAGE_SIZE))
+			fail ("parent data changed at offset %zu", i);
+	msg ("parent data unchanged");
+
+	/* The parent is the last page on each frame now and takes it
+	   over on write. */
+	buf[0] = '@';
+	CHECK (buf[0] == '@' && buf[1] == 'a', "parent writes its page");
+}
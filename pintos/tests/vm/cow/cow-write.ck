@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(cow-write) begin
+(cow-write) child wrote every page
+child: exit(0)
+(cow-write) wait for child
+(cow-write) parent data unchanged
+(cow-write) parent writes its page
+(cow-write) end
+cow-write: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Blocks a child in FUTEX_WAIT on a word in a page that fork()
+   shared with the parent, and checks that FUTEX_WAKE from the
+   parent, which only reads the shared page, wakes it. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* On a page of its own, so that nothing else the parent writes
+   breaks the sharing. */
+static int word[1024] __attribute__ ((aligned (4096)));
+
+void
+test_main (void) 
+{
+  pid_t child;
+  int woken;
+
+  word[0] = 7;
+  child = fork ("child");
+  if (child == 0)
+    {
+      int result = futex (&word[0], FUTEX_WAIT, 7);
+      CHECK (result == 0, "child woken");
+      exit (0);
+    }
+
+  /* Spin until the child has gone to sleep on the word. */
+  while ((woken = futex (&word[0], FUTEX_WAKE, 1)) == 0)
+    continue;
+  CHECK (wait (child) == 0, "wait for child");
+  CHECK (woken == 1, "parent woke %d waiter", woken);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-fork) begin
+(futex-fork) child woken
+child: exit(0)
+(futex-fork) wait for child
+(futex-fork) parent woke 1 waiter
+(futex-fork) end
+futex-fork: exit(0)
+EOF
+pass;
@@ -0,0 +1,56 @@
+/* Fills more memory than there is with a nonzero pattern, so
+   that frames have to be recycled, and then writes to pages of
+   a bss array that were never touched before.  Every byte of a
+   bss page other than the ones written must still read as zero,
+   whichever frame the page landed on.
+   For this test, Pintos memory size is 10MB. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define DIRTY_SIZE (12 * ONE_MB)
+#define BSS_SIZE (8 * ONE_MB)
+
+static char dirty[DIRTY_SIZE];
+static char bss[BSS_SIZE];
+
+static void
+check_bss_page (size_t page)
+{
+  const char *p = bss + page * PAGE_SIZE;
+  size_t i;
+
+  if (p[0] != 1)
+    fail ("bss page %zu lost its first byte", page);
+  for (i = 1; i < PAGE_SIZE; i++)
+    if (p[i] != 0)
+      fail ("bss page %zu has nonzero byte at offset %zu", page, i);
+}
+
+void
+test_main (void) 
+{
+  size_t page;
+
+  for (page = 0; page < DIRTY_SIZE / PAGE_SIZE; page++)
+    memset (dirty + page * PAGE_SIZE, 0xa5, PAGE_SIZE);
+  msg ("filled memory with a pattern");
+
+  for (page = 0; page < BSS_SIZE / PAGE_SIZE; page++)
+    {
+      bss[page * PAGE_SIZE] = 1;
+      check_bss_page (page);
+    }
+  msg ("first writes to bss see zeros");
+
+  for (page = 0; page < DIRTY_SIZE / PAGE_SIZE; page++)
+    if (dirty[page * PAGE_SIZE] != (char) 0xa5)
+      fail ("pattern page %zu is inconsistent", page);
+  for (page = 0; page < BSS_SIZE / PAGE_SIZE; page++)
+    check_bss_page (page);
+  msg ("bss still zero after swapping");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-bss) begin
+(swap-bss) filled memory with a pattern
+(swap-bss) first writes to bss see zeros
+(swap-bss) bss still zero after swapping
+(swap-bss) end
+EOF
+pass;
@@ -21,6 +21,7 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -32,6 +33,7 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -154,13 +156,31 @@ static void paging_init(uint64_t mem_end)
 	pml4 = base_pml4 = palloc_get_page(PAL_ASSERT | PAL_ZERO);
 
 	extern char start, _end_kernel_text;
+	uint64_t text_start = (uint64_t)&start, text_end = (uint64_t)&_end_kernel_text;
+	bool huge = cpu_has_huge_pages();
+	uint64_t pa, size;
+
 	// Maps physical address [0 ~ mem_end] to
 	//   [LOADER_KERN_BASE ~ LOADER_KERN_BASE + mem_end].
-	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
+	// 1 GiB and 2 MiB pages are used wherever the range allows and both
+	// addresses are aligned to the page size, which keeps the direct map
+	// out of most of the TLB. Pages that overlap the read-only kernel
+	// text stay 4 KiB so the protection is exact.
+	for (pa = 0; pa < mem_end; pa += size) {
 		uint64_t va = (uint64_t)ptov(pa);
 
 		perm = PTE_P | PTE_W;
-		if ((uint64_t)&start <= va && va < (uint64_t)&_end_kernel_text)
+		size = huge ? HUGE_PAGE_SIZE : LARGE_PAGE_SIZE;
+		for (; size > PGSIZE; size = size == HUGE_PAGE_SIZE ? LARGE_PAGE_SIZE : PGSIZE)
+			if (pa % size == 0 && va % size == 0 && pa + size <= mem_end &&
+				(va + size <= text_start || va >= text_end))
+				break;
+		if (size != PGSIZE) {
+			pml4_set_large_page(pml4, (void *)va, pa, size, perm);
+			continue;
+		}
+
+		if (text_start <= va && va < text_end)
 			perm &= ~PTE_W;
 
 		if ((pte = pml4e_walk(pml4, va, 1)) != NULL)
@@ -225,11 +245,17 @@ static char **parse_options(char **argv)
 			random_init(atoi(value));
 		else if (!strcmp(name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp(name, "-fair"))
+			thread_fair = true;
 #ifdef USERPROG
 		else if (!strcmp(name, "-ul"))
 			user_page_limit = atoi(value);
 		else if (!strcmp(name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp(name, "-zswap"))
+			zswap_page_limit = atoi(value);
 #endif
 		else
 			PANIC("unknown option `%s' (use -h for help)", name);
@@ -326,8 +352,12 @@ static void usage(void)
 		   "  -f                 Format file system disk during startup.\n"
 		   "  -rs=SEED           Set random number seed to SEED.\n"
 		   "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+		   "  -fair              Use fair-share scheduler.\n"
 #ifdef USERPROG
 		   "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+		   "  -zswap=COUNT       Limit compressed swap cache to COUNT pages.\n"
 #endif
 	);
 	power_off();
@@ -354,6 +384,7 @@ static void print_stats(void)
 {
 	timer_print_stats();
 	thread_print_stats();
+	malloc_print_stats();
 #ifdef FILESYS
 	disk_print_stats();
 #endif
@@ -362,4 +393,7 @@ static void print_stats(void)
 #ifdef USERPROG
 	exception_print_stats();
 #endif
+#ifdef VM
+	vm_print_stats();
+#endif
 }
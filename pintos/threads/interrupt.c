@@ -97,6 +97,15 @@ static const char *intr_names[INTR_CNT];
 static bool in_external_intr; /* Are we processing an external interrupt? */
 static bool yield_on_return;  /* Should we yield on interrupt return? */
 
+/* Softirqs raised but not yet run, and whether softirq_run() is
+   running them.  External interrupts that arrive while softirqs
+   run do not yield themselves; they leave yield_on_return set
+   for the handler that started softirq_run(). */
+static struct list softirq_list;
+static bool in_softirq;
+
+static void softirq_run(void);
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init(void);
 static void pic_end_of_interrupt(int irq);
@@ -161,6 +170,8 @@ void intr_init(void)
 	/* Initialize interrupt controller. */
 	pic_init();
 
+	list_init(&softirq_list);
+
 	/* Initialize IDT. */
 	for (i = 0; i < INTR_CNT; i++) {
 		make_intr_gate(&idt[i], intr_stubs[i], 0);
@@ -250,16 +261,77 @@ bool intr_context(void)
 	return in_external_intr;
 }
 
-/* During processing of an external interrupt, directs the
-   interrupt handler to yield to a new process just before
-   returning from the interrupt.  May not be called at any other
-   time. */
+/* During processing of an external interrupt or a softirq,
+   directs the interrupt handler to yield to a new process just
+   before returning from the interrupt.  May not be called at any
+   other time. */
 void intr_yield_on_return(void)
 {
-	ASSERT(intr_context());
+	ASSERT(intr_context() || softirq_context());
 	yield_on_return = true;
 }
 
+/* Initializes softirq S to run FUNC, passing AUX. */
+void softirq_init(struct softirq *s, softirq_func *func, void *aux)
+{
+	ASSERT(s != NULL);
+	ASSERT(func != NULL);
+
+	s->pending = false;
+	s->func = func;
+	s->aux = aux;
+}
+
+/* Arranges for S to run before the current external interrupt
+   returns, or before the next one returns if called elsewhere.
+   Raising a softirq that is already pending has no effect. */
+void softirq_raise(struct softirq *s)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (!s->pending) {
+		s->pending = true;
+		list_push_back(&softirq_list, &s->elem);
+	}
+	intr_set_level(old_level);
+}
+
+/* Returns true while a softirq is running, false otherwise. */
+bool softirq_context(void)
+{
+	return in_softirq;
+}
+
+/* Runs the softirqs pending on entry with interrupts enabled.
+   Ones raised meanwhile, including those that re-raise
+   themselves, wait for the next interrupt so that this loop
+   cannot run forever.  Called and returns with interrupts
+   off. */
+static void softirq_run(void)
+{
+	struct list batch;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(!intr_context());
+
+	if (list_empty(&softirq_list))
+		return;
+
+	list_init(&batch);
+	list_splice(list_end(&batch), list_begin(&softirq_list), list_end(&softirq_list));
+
+	in_softirq = true;
+	while (!list_empty(&batch)) {
+		struct softirq *s = list_entry(list_pop_front(&batch), struct softirq, elem);
+
+		s->pending = false;
+		intr_enable();
+		s->func(s->aux);
+		intr_disable();
+	}
+	in_softirq = false;
+}
+
 /* 8259A Programmable Interrupt Controller. */
 
 /* Every PC has two 8259A Programmable Interrupt Controller (PIC)
@@ -334,7 +406,8 @@ void intr_handler(struct intr_frame *frame)
 		ASSERT(!intr_context());
 
 		in_external_intr = true;
-		yield_on_return = false;
+		if (!in_softirq)
+			yield_on_return = false;
 	}
 
 	/* Invoke the interrupt's handler. */
@@ -360,8 +433,11 @@ void intr_handler(struct intr_frame *frame)
 		in_external_intr = false;
 		pic_end_of_interrupt(frame->vec_no);
 
-		if (yield_on_return)
-			thread_yield();
+		if (!in_softirq) {
+			softirq_run();
+			if (yield_on_return)
+				thread_yield();
+		}
 	}
 }
 
@@ -11,22 +11,24 @@
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
-
-   Otherwise, a new page of memory, called an "arena", is
-   obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
-
-   When we free a block, we add it to its descriptor's free list.
-   But if the arena that the block was in now has no in-use
-   blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
+   The size of each request, in bytes, is rounded up to the
+   nearest size class and assigned to the "descriptor" that
+   manages blocks of that size.  The classes are the powers of 2
+   from 16 to 1024 and 1.5 times each of them from 32 up, so no
+   request over 32 bytes wastes more than a third of its block.
+
+   Blocks are carved out of pages of memory called "arenas".
+   Each arena keeps its own list of free blocks, and the
+   descriptor keeps a list of the arenas that have any.  A
+   request is satisfied from the first such arena.  If there is
+   none, a new arena is obtained from the page allocator (if none
+   is available, malloc() returns a null pointer), divided into
+   blocks, and put on the descriptor's list.
+
+   When we free a block, we add it to its arena's free list.  If
+   the arena now has no in-use blocks, we take it off the
+   descriptor's list and give it back to the page allocator, both
+   in constant time.
 
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
@@ -38,8 +40,14 @@
 struct desc {
 	size_t block_size;		 /* Size of each element in bytes. */
 	size_t blocks_per_arena; /* Number of blocks in an arena. */
-	struct list free_list;	 /* List of free blocks. */
+	struct list arena_list;	 /* Arenas that have free blocks. */
 	struct lock lock;		 /* Lock. */
+
+	/* Statistics. */
+	size_t arena_cnt;		  /* Arenas currently allocated. */
+	size_t in_use;			  /* Blocks currently allocated. */
+	uint64_t alloc_cnt;		  /* Blocks ever allocated. */
+	uint64_t requested_bytes; /* Bytes ever requested from them. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -47,20 +55,23 @@ struct desc {
 
 /* Arena. */
 struct arena {
-	unsigned magic;	   /* Always set to ARENA_MAGIC. */
-	struct desc *desc; /* Owning descriptor, null for big block. */
-	size_t free_cnt;   /* Free blocks; pages in big block. */
+	unsigned magic;			/* Always set to ARENA_MAGIC. */
+	struct desc *desc;		/* Owning descriptor, null for big block. */
+	size_t free_cnt;		/* Free blocks; pages in big block. */
+	struct block *free;		/* First free block. */
+	struct list_elem elem;	/* Element in descriptor's arena_list. */
 };
 
 /* Free block. */
 struct block {
-	struct list_elem free_elem; /* Free list element. */
+	struct block *next; /* Next free block in the same arena. */
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10]; /* Descriptors. */
+static struct desc descs[13]; /* Descriptors. */
 static size_t desc_cnt;		  /* Number of descriptors. */
 
+static void add_desc(size_t block_size);
 static struct arena *block_to_arena(struct block *);
 static struct block *arena_to_block(struct arena *, size_t idx);
 
@@ -70,12 +81,47 @@ void malloc_init(void)
 	size_t block_size;
 
 	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-		struct desc *d = &descs[desc_cnt++];
-		ASSERT(desc_cnt <= sizeof descs / sizeof *descs);
-		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof(struct arena)) / block_size;
-		list_init(&d->free_list);
-		lock_init(&d->lock);
+		add_desc(block_size);
+		if (block_size >= 32 && block_size + block_size / 2 < PGSIZE / 2)
+			add_desc(block_size + block_size / 2);
+	}
+}
+
+/* Appends a descriptor for blocks of BLOCK_SIZE bytes. */
+static void add_desc(size_t block_size)
+{
+	struct desc *d = &descs[desc_cnt++];
+
+	ASSERT(desc_cnt <= sizeof descs / sizeof *descs);
+	ASSERT(block_size % sizeof(void *) == 0);
+	d->block_size = block_size;
+	d->blocks_per_arena = (PGSIZE - sizeof(struct arena)) / block_size;
+	list_init(&d->arena_list);
+	lock_init(&d->lock);
+	d->arena_cnt = d->in_use = 0;
+	d->alloc_cnt = d->requested_bytes = 0;
+}
+
+/* Prints, for each size class in use, its arenas and blocks and
+   the share of its allocations lost to rounding up. */
+void malloc_print_stats(void)
+{
+	struct desc *d;
+
+	for (d = descs; d < descs + desc_cnt; d++) {
+		uint64_t block_bytes;
+		size_t waste;
+
+		lock_acquire(&d->lock);
+		if (d->alloc_cnt == 0) {
+			lock_release(&d->lock);
+			continue;
+		}
+		block_bytes = d->alloc_cnt * d->block_size;
+		waste = (block_bytes - d->requested_bytes) * 100 / block_bytes;
+		printf("Malloc: %4zu-byte class: %zu arenas, %zu in use, %llu allocated, %zu%% waste\n",
+			   d->block_size, d->arena_cnt, d->in_use, d->alloc_cnt, waste);
+		lock_release(&d->lock);
 	}
 }
 
@@ -114,8 +160,8 @@ void *malloc(size_t size)
 
 	lock_acquire(&d->lock);
 
-	/* If the free list is empty, create a new arena. */
-	if (list_empty(&d->free_list)) {
+	/* If no arena has a free block, create a new arena. */
+	if (list_empty(&d->arena_list)) {
 		size_t i;
 
 		/* Allocate a page. */
@@ -125,20 +171,31 @@ void *malloc(size_t size)
 			return NULL;
 		}
 
-		/* Initialize arena and add its blocks to the free list. */
+		/* Initialize arena and chain its blocks, in address
+		   order, into its free list. */
 		a->magic = ARENA_MAGIC;
 		a->desc = d;
 		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
+		a->free = NULL;
+		for (i = d->blocks_per_arena; i-- > 0;) {
 			struct block *b = arena_to_block(a, i);
-			list_push_back(&d->free_list, &b->free_elem);
+			b->next = a->free;
+			a->free = b;
 		}
+		list_push_front(&d->arena_list, &a->elem);
+		d->arena_cnt++;
 	}
 
-	/* Get a block from free list and return it. */
-	b = list_entry(list_pop_front(&d->free_list), struct block, free_elem);
-	a = block_to_arena(b);
-	a->free_cnt--;
+	/* Get a block from the first arena's free list and return
+	   it, retiring the arena from the list if it is now full. */
+	a = list_entry(list_front(&d->arena_list), struct arena, elem);
+	b = a->free;
+	a->free = b->next;
+	if (--a->free_cnt == 0)
+		list_remove(&a->elem);
+	d->in_use++;
+	d->alloc_cnt++;
+	d->requested_bytes += size;
 	lock_release(&d->lock);
 	return b;
 }
@@ -215,18 +272,20 @@ void free(void *p)
 
 			lock_acquire(&d->lock);
 
-			/* Add block to free list. */
-			list_push_front(&d->free_list, &b->free_elem);
+			/* Add block to its arena's free list, putting the
+			   arena back on the descriptor's list if it was
+			   full. */
+			b->next = a->free;
+			a->free = b;
+			if (a->free_cnt++ == 0)
+				list_push_front(&d->arena_list, &a->elem);
+			d->in_use--;
 
 			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
+			if (a->free_cnt >= d->blocks_per_arena) {
 				ASSERT(a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block(a, i);
-					list_remove(&b->free_elem);
-				}
+				list_remove(&a->elem);
+				d->arena_cnt--;
 				palloc_free_page(a);
 			}
 
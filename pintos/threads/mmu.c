@@ -8,11 +8,26 @@
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
-static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create)
+static uint64_t *next_level(uint64_t *table, unsigned idx);
+static uint64_t *pml4e_walk_sized(uint64_t *pml4e, const uint64_t va, int create,
+								  uint64_t *size);
+
+/* The walkers below stop early at an entry with PTE_PS set, which
+ * maps a whole 2 MiB or 1 GiB page, and return a pointer to that
+ * entry instead of to a PTE.  If SIZE is nonnull, they store the
+ * size of the page mapped by the returned entry in *SIZE.  Only
+ * the kernel's direct map uses large pages. */
+
+static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create, uint64_t *size)
 {
 	int idx = PDX(va);
 	if (pdp) {
 		uint64_t *pte = (uint64_t *)pdp[idx];
+		if (((uint64_t)pte & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS)) {
+			if (size)
+				*size = LARGE_PAGE_SIZE;
+			return &pdp[idx];
+		}
 		if (!((uint64_t)pte & PTE_P)) {
 			if (create) {
 				uint64_t *new_page = palloc_get_page(PAL_ZERO);
@@ -23,18 +38,25 @@ static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create)
 			} else
 				return NULL;
 		}
+		if (size)
+			*size = PGSIZE;
 		return (uint64_t *)ptov(PTE_ADDR(pdp[idx]) + 8 * PTX(va));
 	}
 	return NULL;
 }
 
-static uint64_t *pdpe_walk(uint64_t *pdpe, const uint64_t va, int create)
+static uint64_t *pdpe_walk(uint64_t *pdpe, const uint64_t va, int create, uint64_t *size)
 {
 	uint64_t *pte = NULL;
 	int idx = PDPE(va);
 	int allocated = 0;
 	if (pdpe) {
 		uint64_t *pde = (uint64_t *)pdpe[idx];
+		if (((uint64_t)pde & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS)) {
+			if (size)
+				*size = HUGE_PAGE_SIZE;
+			return &pdpe[idx];
+		}
 		if (!((uint64_t)pde & PTE_P)) {
 			if (create) {
 				uint64_t *new_page = palloc_get_page(PAL_ZERO);
@@ -46,7 +68,7 @@ static uint64_t *pdpe_walk(uint64_t *pdpe, const uint64_t va, int create)
 			} else
 				return NULL;
 		}
-		pte = pgdir_walk(ptov(PTE_ADDR(pdpe[idx])), va, create);
+		pte = pgdir_walk(ptov(PTE_ADDR(pdpe[idx])), va, create, size);
 	}
 	if (pte == NULL && allocated) {
 		palloc_free_page((void *)ptov(PTE_ADDR(pdpe[idx])));
@@ -60,8 +82,18 @@ static uint64_t *pdpe_walk(uint64_t *pdpe, const uint64_t va, int create)
  * If PML4E does not have a page table for VADDR, behavior depends
  * on CREATE.  If CREATE is true, then a new page table is
  * created and a pointer into it is returned.  Otherwise, a null
- * pointer is returned. */
+ * pointer is returned.
+ * If VADDR lies in a large page, the returned pointer is to the
+ * PDE or PDPE that maps it, which has PTE_PS set. */
 uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create)
+{
+	return pml4e_walk_sized(pml4e, va, create, NULL);
+}
+
+/* Like pml4e_walk(), but also stores the size of the page that
+ * maps VADDR in *SIZE if SIZE is nonnull. */
+static uint64_t *pml4e_walk_sized(uint64_t *pml4e, const uint64_t va, int create,
+								  uint64_t *size)
 {
 	uint64_t *pte = NULL;
 	int idx = PML4(va);
@@ -79,7 +111,7 @@ uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create)
 			} else
 				return NULL;
 		}
-		pte = pdpe_walk(ptov(PTE_ADDR(pml4e[idx])), va, create);
+		pte = pdpe_walk(ptov(PTE_ADDR(pml4e[idx])), va, create, size);
 	}
 	if (pte == NULL && allocated) {
 		palloc_free_page((void *)ptov(PTE_ADDR(pml4e[idx])));
@@ -88,6 +120,53 @@ uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create)
 	return pte;
 }
 
+/* Returns the kernel virtual address of the table that entry IDX
+ * of TABLE points to, creating an empty one if the entry is not
+ * present.  Returns a null pointer if memory allocation fails.
+ * The entry must not map a large page. */
+static uint64_t *next_level(uint64_t *table, unsigned idx)
+{
+	if (!(table[idx] & PTE_P)) {
+		uint64_t *new_page = palloc_get_page(PAL_ZERO);
+		if (new_page == NULL)
+			return NULL;
+		table[idx] = vtop(new_page) | PTE_U | PTE_W | PTE_P;
+	}
+	ASSERT(!(table[idx] & PTE_PS));
+	return ptov(PTE_ADDR(table[idx]));
+}
+
+/* Maps the SIZE bytes at virtual address VA in PML4 to physical
+ * address PA with a single large page, whose entry gets
+ * permission bits PERM.  SIZE must be LARGE_PAGE_SIZE or
+ * HUGE_PAGE_SIZE, and VA and PA must be aligned to it.  Nothing
+ * in the range may be mapped yet.  Returns true if successful,
+ * false if memory for a page table could not be obtained. */
+bool pml4_set_large_page(uint64_t *pml4, void *va, uint64_t pa, uint64_t size, int perm)
+{
+	uint64_t *pdp, *pd;
+
+	ASSERT(size == LARGE_PAGE_SIZE || size == HUGE_PAGE_SIZE);
+	ASSERT((uint64_t)va % size == 0);
+	ASSERT(pa % size == 0);
+
+	pdp = next_level(pml4, PML4(va));
+	if (pdp == NULL)
+		return false;
+	if (size == HUGE_PAGE_SIZE) {
+		ASSERT(!(pdp[PDPE(va)] & PTE_P));
+		pdp[PDPE(va)] = pa | perm | PTE_PS;
+		return true;
+	}
+
+	pd = next_level(pdp, PDPE(va));
+	if (pd == NULL)
+		return false;
+	ASSERT(!(pd[PDX(va)] & PTE_P));
+	pd[PDX(va)] = pa | perm | PTE_PS;
+	return true;
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -121,9 +200,15 @@ static bool pgdir_for_each(uint64_t *pdp, pte_for_each_func *func, void *aux, un
 {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *)pdp[i]);
-		if (((uint64_t)pte) & PTE_P)
-			if (!pt_for_each((uint64_t *)PTE_ADDR(pte), func, aux, pml4_index, pdp_index, i))
+		if (!(((uint64_t)pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS) {
+			void *va = (void *)(((uint64_t)pml4_index << PML4SHIFT) |
+								((uint64_t)pdp_index << PDPESHIFT) | ((uint64_t)i << PDXSHIFT));
+			if (!func(&pdp[i], va, aux))
 				return false;
+		} else if (!pt_for_each((uint64_t *)PTE_ADDR(pte), func, aux, pml4_index, pdp_index, i))
+			return false;
 	}
 	return true;
 }
@@ -132,14 +217,21 @@ static bool pdp_for_each(uint64_t *pdp, pte_for_each_func *func, void *aux, unsi
 {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pde = ptov((uint64_t *)pdp[i]);
-		if (((uint64_t)pde) & PTE_P)
-			if (!pgdir_for_each((uint64_t *)PTE_ADDR(pde), func, aux, pml4_index, i))
+		if (!(((uint64_t)pde) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS) {
+			void *va = (void *)(((uint64_t)pml4_index << PML4SHIFT) | ((uint64_t)i << PDPESHIFT));
+			if (!func(&pdp[i], va, aux))
 				return false;
+		} else if (!pgdir_for_each((uint64_t *)PTE_ADDR(pde), func, aux, pml4_index, i))
+			return false;
 	}
 	return true;
 }
 
-/* Apply FUNC to each available pte entries including kernel's. */
+/* Apply FUNC to each available pte entries including kernel's.
+ * A large page is passed to FUNC as its PDE or PDPE, which has
+ * PTE_PS set, and the virtual address of its first byte. */
 bool pml4_for_each(uint64_t *pml4, pte_for_each_func *func, void *aux)
 {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
@@ -165,7 +257,7 @@ static void pgdir_destroy(uint64_t *pdp)
 {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *)pdp[i]);
-		if (((uint64_t)pte) & PTE_P)
+		if ((((uint64_t)pte) & PTE_P) && !(pdp[i] & PTE_PS))
 			pt_destroy(PTE_ADDR(pte));
 	}
 	palloc_free_page((void *)pdp);
@@ -175,7 +267,7 @@ static void pdpe_destroy(uint64_t *pdpe)
 {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pde = ptov((uint64_t *)pdpe[i]);
-		if (((uint64_t)pde) & PTE_P)
+		if ((((uint64_t)pde) & PTE_P) && !(pdpe[i] & PTE_PS))
 			pgdir_destroy((void *)PTE_ADDR(pde));
 	}
 	palloc_free_page((void *)pdpe);
@@ -210,10 +302,11 @@ void *pml4_get_page(uint64_t *pml4, const void *uaddr)
 {
 	ASSERT(is_user_vaddr(uaddr));
 
-	uint64_t *pte = pml4e_walk(pml4, (uint64_t)uaddr, 0);
+	uint64_t size;
+	uint64_t *pte = pml4e_walk_sized(pml4, (uint64_t)uaddr, 0, &size);
 
 	if (pte && (*pte & PTE_P))
-		return ptov(PTE_ADDR(*pte)) + pg_ofs(uaddr);
+		return ptov(PTE_ADDR(*pte) & ~(size - 1)) + ((uint64_t)uaddr & (size - 1));
 	return NULL;
 }
 
@@ -2,14 +2,15 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,13 +25,55 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Free memory is kept as
+   blocks of 2**ORDER pages, each aligned to its own size relative
+   to the pool base, on one free list per order.  An allocation
+   splits the smallest large-enough block, and a free merges the
+   block with its "buddy", the other half of the block of the
+   next order up, for as long as the buddy is free too.  Both take
+   O(log n) time.  A request for a page count that is not a power
+   of 2 takes the next larger block and gives back the tail.
+
+   The free list element of a free block lives in its first page,
+   and `order' records, for each page, the order of the free
+   block that starts there, or ORDER_NONE.  The pools are
+   protected by disabling interrupts, because pages are freed
+   from the scheduler.
+
+   Each pool also keeps up to ZEROED_TARGET pages that the idle
+   thread has already zeroed (see palloc_zero_ahead()), so that a
+   PAL_ZERO request for a single page, such as a page fault's
+   new frame, need not clear it on the spot.  These pages count
+   as allocated as far as the buddy allocator is concerned, so
+   they can split up the free blocks a multi-page request needs;
+   such a request that fails gives them all back and retries.
+   The reserve is also kept to a small share of the pool. */
+
+/* Number of block orders: the largest block is 2**(ORDER_CNT - 1)
+   pages. */
+#define ORDER_CNT 20
+
+/* `order' entry of a page that does not start a free block. */
+#define ORDER_NONE UINT8_MAX
+
+/* Number of pre-zeroed pages each pool aims to keep, at most one
+   page in every ZEROED_SHARE of the pool. */
+#define ZEROED_TARGET 64
+#define ZEROED_SHARE 32
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;		 /* Mutual exclusion. */
-	struct bitmap *used_map; /* Bitmap of free pages. */
-	uint8_t *base;			 /* Base of pool. */
+	size_t page_cnt;			 /* Number of pages in pool. */
+	uint8_t *base;				 /* Base of pool. */
+	uint8_t *order;				 /* Order of free block at each page. */
+	struct list free[ORDER_CNT]; /* Free blocks of each order. */
+	struct list zeroed;			 /* Pages zeroed in advance. */
+	size_t zeroed_cnt;			 /* Number of pages in `zeroed'. */
+#ifndef NDEBUG
+	struct bitmap *used_map; /* Allocated pages, to cross-check. */
+#endif
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -42,6 +85,14 @@ static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t e
 
 static bool page_from_pool(const struct pool *, void *page);
 
+static size_t buddy_alloc(struct pool *, unsigned order);
+static void buddy_free(struct pool *, size_t page_idx, unsigned order);
+static void pool_release(struct pool *, size_t page_idx, size_t page_cnt);
+static struct list_elem *block_elem(const struct pool *, size_t page_idx);
+static size_t block_idx(const struct pool *, struct list_elem *);
+static void *zeroed_pop(struct pool *);
+static void zeroed_release(struct pool *);
+
 /* multiboot info */
 struct multiboot_info {
 	uint32_t flags;
@@ -214,16 +265,16 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem)
 			else
 				NOT_REACHED();
 
-			pool_end = pool->base + bitmap_size(pool->used_map) * PGSIZE;
+			pool_end = pool->base + pool->page_cnt * PGSIZE;
 			page_idx = pg_no(start) - pg_no(pool->base);
 			if ((uint64_t)pool_end < end) {
 				page_cnt = ((uint64_t)pool_end - start) / PGSIZE;
-				bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+				pool_release(pool, page_idx, page_cnt);
 				start = (uint64_t)pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t)end - start) / PGSIZE;
-				bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+				pool_release(pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -257,19 +308,47 @@ uint64_t palloc_init(void)
 void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt)
 {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	enum intr_level old_level;
+	unsigned order = 0;
+	size_t page_idx;
+	void *pages = NULL;
+	bool zeroed = false;
+
+	if (page_cnt == 0)
+		return NULL;
+	while (((size_t)1 << order) < page_cnt)
+		order++;
+
+	old_level = intr_disable();
+	if (page_cnt == 1 && (flags & PAL_ZERO) && pool->zeroed_cnt > 0) {
+		pages = zeroed_pop(pool);
+		zeroed = true;
+	} else {
+		page_idx = buddy_alloc(pool, order);
+		if (page_idx == BITMAP_ERROR && page_cnt > 1 && pool->zeroed_cnt > 0) {
+			/* The zeroed pages may be what keeps a large enough
+			   block from forming. */
+			zeroed_release(pool);
+			page_idx = buddy_alloc(pool, order);
+		}
 
-	lock_acquire(&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
-	lock_release(&pool->lock);
-	void *pages;
-
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+		if (page_idx != BITMAP_ERROR) {
+			pool_release(pool, page_idx + page_cnt, ((size_t)1 << order) - page_cnt);
+#ifndef NDEBUG
+			ASSERT(bitmap_none(pool->used_map, page_idx, page_cnt));
+			bitmap_set_multiple(pool->used_map, page_idx, page_cnt, true);
+#endif
+			pages = pool->base + PGSIZE * page_idx;
+		} else if (page_cnt == 1 && pool->zeroed_cnt > 0) {
+			/* Out of free memory: fall back on the zeroed pages. */
+			pages = zeroed_pop(pool);
+			zeroed = true;
+		}
+	}
+	intr_set_level(old_level);
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset(pages, 0, PGSIZE * page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
@@ -295,6 +374,7 @@ void *palloc_get_page(enum palloc_flags flags)
 void palloc_free_multiple(void *pages, size_t page_cnt)
 {
 	struct pool *pool;
+	enum intr_level old_level;
 	size_t page_idx;
 
 	ASSERT(pg_ofs(pages) == 0);
@@ -313,8 +393,13 @@ void palloc_free_multiple(void *pages, size_t page_cnt)
 #ifndef NDEBUG
 	memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	old_level = intr_disable();
+#ifndef NDEBUG
 	ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+#endif
+	pool_release(pool, page_idx, page_cnt);
+	intr_set_level(old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -323,23 +408,78 @@ void palloc_free_page(void *page)
 	palloc_free_multiple(page, 1);
 }
 
+/* Zeroes one free page for later PAL_ZERO requests, taking it
+   from the user pool first, since page faults draw from it.
+   Returns true if it zeroed a page, false if every pool already
+   has as many zeroed pages as it aims to keep or no free page to
+   zero.
+
+   Meant to be called by the idle thread, with interrupts on, one
+   page at a time between checks for other work to do. */
+bool palloc_zero_ahead(void)
+{
+	struct pool *pools[] = {&user_pool, &kernel_pool};
+
+	ASSERT(intr_get_level() == INTR_ON);
+
+	for (size_t i = 0; i < sizeof pools / sizeof *pools; i++) {
+		struct pool *pool = pools[i];
+		size_t page_idx;
+		uint8_t *page;
+
+		if (pool->zeroed_cnt >= ZEROED_TARGET ||
+			pool->zeroed_cnt >= pool->page_cnt / ZEROED_SHARE)
+			continue;
+
+		intr_disable();
+		page_idx = buddy_alloc(pool, 0);
+#ifndef NDEBUG
+		if (page_idx != BITMAP_ERROR)
+			bitmap_mark(pool->used_map, page_idx);
+#endif
+		intr_enable();
+		if (page_idx == BITMAP_ERROR)
+			continue;
+
+		page = pool->base + PGSIZE * page_idx;
+		memset(page, 0, PGSIZE);
+
+		intr_disable();
+		list_push_back(&pool->zeroed, (struct list_elem *)page);
+		pool->zeroed_cnt++;
+		intr_enable();
+		return true;
+	}
+	return false;
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end)
 {
-	/* We'll put the pool's used_map at its base.
-	   Calculate the space needed for the bitmap
-	   and subtract it from the pool's size. */
+	/* We'll put the pool's order map (and used_map) at BM_BASE.
+	   Calculate the space needed and advance BM_BASE past it. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+	size_t order_bytes = ROUND_UP(pgcnt, PGSIZE);
 
-	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
+	p->page_cnt = pgcnt;
 	p->base = (void *)start;
+	for (int i = 0; i < ORDER_CNT; i++)
+		list_init(&p->free[i]);
+	list_init(&p->zeroed);
+	p->zeroed_cnt = 0;
 
-	// Mark all to unusable.
-	bitmap_set_all(p->used_map, true);
+	// Mark all to unusable: no page starts a free block.
+	p->order = *bm_base;
+	memset(p->order, ORDER_NONE, pgcnt);
+	*bm_base += order_bytes;
 
+#ifndef NDEBUG
+	size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+
+	p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
+	bitmap_set_all(p->used_map, true);
 	*bm_base += bm_pages;
+#endif
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -348,6 +488,121 @@ static bool page_from_pool(const struct pool *pool, void *page)
 {
 	size_t page_no = pg_no(page);
 	size_t start_page = pg_no(pool->base);
-	size_t end_page = start_page + bitmap_size(pool->used_map);
+	size_t end_page = start_page + pool->page_cnt;
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Removes a free block of 2**ORDER pages from POOL and returns
+   the index of its first page, splitting a larger block if
+   necessary.  Returns BITMAP_ERROR if there is none. */
+static size_t buddy_alloc(struct pool *pool, unsigned order)
+{
+	unsigned k = order;
+	size_t page_idx;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	while (k < ORDER_CNT && list_empty(&pool->free[k]))
+		k++;
+	if (k >= ORDER_CNT)
+		return BITMAP_ERROR;
+
+	page_idx = block_idx(pool, list_pop_front(&pool->free[k]));
+	pool->order[page_idx] = ORDER_NONE;
+
+	/* Put the upper half of each split back on the free list
+	   one order down. */
+	while (k > order) {
+		size_t half;
+
+		k--;
+		half = page_idx + ((size_t)1 << k);
+		pool->order[half] = k;
+		list_push_front(&pool->free[k], block_elem(pool, half));
+	}
+	return page_idx;
+}
+
+/* Returns the block of 2**ORDER pages at PAGE_IDX to POOL,
+   merging it with its buddy as long as the buddy is free. */
+static void buddy_free(struct pool *pool, size_t page_idx, unsigned order)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(page_idx % ((size_t)1 << order) == 0);
+	ASSERT(pool->order[page_idx] == ORDER_NONE);
+
+	while (order + 1 < ORDER_CNT) {
+		size_t buddy = page_idx ^ ((size_t)1 << order);
+
+		if (buddy >= pool->page_cnt || pool->order[buddy] != order)
+			break;
+		list_remove(block_elem(pool, buddy));
+		pool->order[buddy] = ORDER_NONE;
+		page_idx &= ~((size_t)1 << order);
+		order++;
+	}
+	pool->order[page_idx] = order;
+	list_push_front(&pool->free[order], block_elem(pool, page_idx));
+}
+
+/* Returns the PAGE_CNT pages starting at PAGE_IDX to POOL, as
+   the largest aligned blocks that cover them. */
+static void pool_release(struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+	while (page_cnt > 0) {
+		unsigned order = 0;
+
+		while (order + 1 < ORDER_CNT && page_idx % ((size_t)2 << order) == 0
+			   && ((size_t)2 << order) <= page_cnt)
+			order++;
+		buddy_free(pool, page_idx, order);
+		page_idx += (size_t)1 << order;
+		page_cnt -= (size_t)1 << order;
+	}
+}
+
+/* Removes and returns a page from POOL's zeroed pages, which
+   must not be empty, clearing the list element it held. */
+static void *zeroed_pop(struct pool *pool)
+{
+	struct list_elem *e;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(pool->zeroed_cnt > 0);
+
+	e = list_pop_front(&pool->zeroed);
+	pool->zeroed_cnt--;
+	memset(e, 0, sizeof *e);
+	return e;
+}
+
+/* Returns all of POOL's zeroed pages to its free blocks. */
+static void zeroed_release(struct pool *pool)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	while (!list_empty(&pool->zeroed)) {
+		uint8_t *page = (uint8_t *)list_pop_front(&pool->zeroed);
+		size_t page_idx = pg_no(page) - pg_no(pool->base);
+
+#ifndef NDEBUG
+		bitmap_reset(pool->used_map, page_idx);
+#endif
+		buddy_free(pool, page_idx, 0);
+	}
+	pool->zeroed_cnt = 0;
+}
+
+/* Returns the free list element stored in the free block that
+   starts at PAGE_IDX in POOL. */
+static struct list_elem *block_elem(const struct pool *pool, size_t page_idx)
+{
+	return (struct list_elem *)(pool->base + PGSIZE * page_idx);
+}
+
+/* Returns the index of the first page of the free block whose
+   list element is ELEM. */
+static size_t block_idx(const struct pool *pool, struct list_elem *elem)
+{
+	return pg_no(elem) - pg_no(pool->base);
+}
@@ -0,0 +1,208 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Object caches.
+
+   malloc() rounds every request up to a power of 2 and shares
+   each size class among all users.  A kmem_cache instead serves
+   a single type: each slab is one page holding a header followed
+   by slots of exactly the object size (rounded up to the
+   requested alignment), so a cache-line-aligned cache never
+   splits an object across lines and the rounding waste of
+   malloc() goes away.
+
+   The free slots of a slab are chained by index through the
+   `next' array in the slab header rather than through the slots
+   themselves, so a freed object keeps the state its constructor
+   gave it.  Slabs with free slots are kept on the cache's
+   `partial' list; full slabs are not on any list.  A slab that
+   becomes empty is returned to the page allocator unless it is
+   the cache's only partial slab. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* End of a slab's free slot chain. */
+#define SLOT_NONE UINT16_MAX
+
+/* Slab header, at the start of each slab's page. */
+struct slab {
+	unsigned magic;			  /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache; /* Owning cache. */
+	struct list_elem elem;	  /* Element in cache's `partial' list. */
+	uint16_t in_use;		  /* Number of allocated slots. */
+	uint16_t free;			  /* First free slot, or SLOT_NONE. */
+	uint16_t next[];		  /* Free slot following each free slot. */
+};
+
+static struct slab *slab_create(struct kmem_cache *);
+static struct slab *obj_to_slab(struct kmem_cache *, void *);
+static void *slab_slot(struct kmem_cache *, struct slab *, size_t idx);
+
+/* Initializes cache C for objects of SIZE bytes, each aligned to
+   ALIGN bytes, a power of 2, or to a pointer if ALIGN is 0.  If
+   CTOR is nonnull, it is run on each new object.  NAME must stay
+   valid as long as C is in use.  No memory is allocated until
+   the first kmem_cache_alloc(). */
+void kmem_cache_init(struct kmem_cache *c, const char *name, size_t size, size_t align,
+					 kmem_ctor_func *ctor)
+{
+	size_t n;
+
+	ASSERT(c != NULL);
+	ASSERT(size > 0);
+	if (align == 0)
+		align = sizeof(void *);
+	ASSERT((align & (align - 1)) == 0);
+
+	c->name = name;
+	c->obj_size = size;
+	c->slot_size = ROUND_UP(size, align);
+	c->ctor = ctor;
+	list_init(&c->partial);
+	lock_init(&c->lock);
+	c->slab_cnt = c->obj_cnt = 0;
+
+	/* Fit as many slots as the header, which grows by one index
+	   per slot, leaves room for. */
+	n = (PGSIZE - sizeof(struct slab)) / (c->slot_size + sizeof(uint16_t));
+	while (n > 0 && ROUND_UP(sizeof(struct slab) + n * sizeof(uint16_t), align) + n * c->slot_size
+						> PGSIZE)
+		n--;
+	ASSERT(n > 0 && n < SLOT_NONE);
+	c->slots_per_slab = n;
+	c->slot_ofs = ROUND_UP(sizeof(struct slab) + n * sizeof(uint16_t), align);
+}
+
+/* Obtains and returns an object from cache C.  Returns a null
+   pointer if memory is not available. */
+void *kmem_cache_alloc(struct kmem_cache *c)
+{
+	struct slab *s;
+	size_t idx;
+
+	lock_acquire(&c->lock);
+
+	/* If no slab has a free slot, create a new slab. */
+	if (list_empty(&c->partial)) {
+		s = slab_create(c);
+		if (s == NULL) {
+			lock_release(&c->lock);
+			return NULL;
+		}
+		list_push_front(&c->partial, &s->elem);
+	}
+
+	/* Take the first free slot of the first partial slab. */
+	s = list_entry(list_front(&c->partial), struct slab, elem);
+	idx = s->free;
+	s->free = s->next[idx];
+	s->in_use++;
+	if (s->free == SLOT_NONE)
+		list_remove(&s->elem);
+	c->obj_cnt++;
+
+	lock_release(&c->lock);
+	return slab_slot(c, s, idx);
+}
+
+/* Obtains an object from cache C and fills it with zeros.
+   Returns a null pointer if memory is not available. */
+void *kmem_cache_zalloc(struct kmem_cache *c)
+{
+	void *obj = kmem_cache_alloc(c);
+
+	if (obj != NULL)
+		memset(obj, 0, c->obj_size);
+	return obj;
+}
+
+/* Returns OBJ, which must have been obtained from cache C, to
+   C.  Does nothing if OBJ is null. */
+void kmem_cache_free(struct kmem_cache *c, void *obj)
+{
+	struct slab *s;
+	size_t idx;
+
+	if (obj == NULL)
+		return;
+
+	s = obj_to_slab(c, obj);
+	idx = (pg_ofs(obj) - c->slot_ofs) / c->slot_size;
+
+	lock_acquire(&c->lock);
+
+	ASSERT(s->in_use > 0);
+	if (s->free == SLOT_NONE)
+		list_push_front(&c->partial, &s->elem);
+	s->next[idx] = s->free;
+	s->free = idx;
+	s->in_use--;
+	c->obj_cnt--;
+
+	/* Give an empty slab back, unless it is the only one with
+	   free slots. */
+	if (s->in_use == 0 && list_front(&c->partial) != list_back(&c->partial)) {
+		list_remove(&s->elem);
+		s->magic = 0;
+		palloc_free_page(s);
+		c->slab_cnt--;
+	}
+
+	lock_release(&c->lock);
+}
+
+/* Allocates a slab for cache C, chains all of its slots into its
+   free list, and runs C's constructor on each.  Returns a null
+   pointer if memory is not available. */
+static struct slab *slab_create(struct kmem_cache *c)
+{
+	struct slab *s;
+	size_t i;
+
+	ASSERT(lock_held_by_current_thread(&c->lock));
+
+	s = palloc_get_page(0);
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->in_use = 0;
+	s->free = 0;
+	for (i = 0; i < c->slots_per_slab; i++) {
+		s->next[i] = i + 1 < c->slots_per_slab ? i + 1 : SLOT_NONE;
+		if (c->ctor != NULL)
+			c->ctor(slab_slot(c, s, i));
+	}
+	c->slab_cnt++;
+	return s;
+}
+
+/* Returns the slab of cache C that OBJ is inside. */
+static struct slab *obj_to_slab(struct kmem_cache *c, void *obj)
+{
+	struct slab *s = pg_round_down(obj);
+
+	/* Check that the slab is valid and belongs to C. */
+	ASSERT(s->magic == SLAB_MAGIC);
+	ASSERT(s->cache == c);
+
+	/* Check that OBJ is properly aligned for the slab. */
+	ASSERT(pg_ofs(obj) >= c->slot_ofs);
+	ASSERT((pg_ofs(obj) - c->slot_ofs) % c->slot_size == 0);
+
+	return s;
+}
+
+/* Returns slot IDX of slab S of cache C. */
+static void *slab_slot(struct kmem_cache *c, struct slab *s, size_t idx)
+{
+	ASSERT(idx < c->slots_per_slab);
+	return (uint8_t *)s + c->slot_ofs + idx * c->slot_size;
+}
@@ -38,7 +38,11 @@
 
 static bool cond_insert_by_priority(struct list_elem *current, struct list_elem *e2,
 									void *aux UNUSED);
-static bool donor_higher_priority(struct list_elem *e1, struct list_elem *e2, void *aux UNUSED);
+static bool donor_higher_priority(const struct heap_elem *, const struct heap_elem *, void *aux);
+static bool lock_higher_priority(const struct heap_elem *, const struct heap_elem *, void *aux);
+static int lock_top_priority(const struct lock *);
+static void lock_donate(struct lock *);
+static void lock_take(struct lock *, struct thread *);
 static bool cond_sema_priority(struct list_elem *a, struct list_elem *b, void *aux UNUSED);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
@@ -180,6 +184,24 @@ void lock_init(struct lock *lock)
 
 	lock->holder = NULL;
 	sema_init(&lock->semaphore, 1);
+	heap_init(&lock->waiters, donor_higher_priority, NULL);
+}
+
+/* Initializes T's donation state, as a thread holding no
+   locks. */
+void lock_init_holder(struct thread *t)
+{
+	heap_init(&t->held_locks, lock_higher_priority, NULL);
+}
+
+/* Returns the highest priority donated to T through the locks it
+   holds, or PRI_MIN if there is none. */
+int lock_donated_priority(const struct thread *t)
+{
+	struct heap_elem *top = heap_top(&t->held_locks);
+	int priority = top != NULL ? lock_top_priority(heap_entry(top, struct lock, holder_elem)) : -1;
+
+	return priority > PRI_MIN ? priority : PRI_MIN;
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -197,27 +219,24 @@ void lock_acquire(struct lock *lock)
 	ASSERT(!lock_held_by_current_thread(lock));
 
 	struct thread *t = thread_current();
-	if (lock->holder != NULL && lock->holder->priority < t->priority) {
-		enum intr_level old = intr_disable();
+	enum intr_level old_level = intr_disable();
+	bool waiting = lock->holder != NULL;
+
+	if (waiting) {
 		t->waiting_lock = lock;
-		struct thread *cur = lock->holder;
-
-		int depth = 0;
-		while (cur && depth < MAX_DEPTH) {
-			cur->priority = t->priority;
-			if (!cur->waiting_lock)
-				break;
-			cur = cur->waiting_lock->holder;
-			depth++;
-		}
-
-		list_push_front(&lock->holder->donor_list, &t->donor_elem);
-		intr_set_level(old);
+		heap_push(&lock->waiters, &t->donor_elem);
+		if (!thread_mlfqs)
+			lock_donate(lock);
 	}
 
 	sema_down(&lock->semaphore);
-	t->waiting_lock = NULL;
-	lock->holder = t;
+
+	if (waiting) {
+		heap_remove(&lock->waiters, &t->donor_elem);
+		t->waiting_lock = NULL;
+	}
+	lock_take(lock, t);
+	intr_set_level(old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -228,14 +247,17 @@ void lock_acquire(struct lock *lock)
    interrupt handler. */
 bool lock_try_acquire(struct lock *lock)
 {
+	enum intr_level old_level;
 	bool success;
 
 	ASSERT(lock != NULL);
 	ASSERT(!lock_held_by_current_thread(lock));
 
+	old_level = intr_disable();
 	success = sema_try_down(&lock->semaphore);
 	if (success)
-		lock->holder = thread_current();
+		lock_take(lock, thread_current());
+	intr_set_level(old_level);
 	return success;
 }
 
@@ -251,22 +273,18 @@ void lock_release(struct lock *lock)
 	ASSERT(lock_held_by_current_thread(lock));
 
 	struct thread *cur = thread_current();
-	int max_priority = lock->holder->base_priority;
-
-	struct list_elem *e;
-	for (e = list_begin(&cur->donor_list); e != list_end(&cur->donor_list); e = list_next(e)) {
-		struct thread *t = list_entry(e, struct thread, donor_elem);
-		if (t->waiting_lock == lock) {
-			list_remove(e);
-			continue;
-		}
-		if (t->priority > max_priority)
-			max_priority = t->priority;
+	enum intr_level old_level = intr_disable();
+
+	/* Give back whatever the waiters for LOCK donated. */
+	heap_remove(&cur->held_locks, &lock->holder_elem);
+	if (!thread_mlfqs) {
+		int donated = lock_donated_priority(cur);
+		thread_update_priority(cur, donated > cur->base_priority ? donated : cur->base_priority);
 	}
-	lock->holder->priority = max_priority;
 
 	lock->holder = NULL;
 	sema_up(&lock->semaphore);
+	intr_set_level(old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -279,6 +297,101 @@ bool lock_held_by_current_thread(const struct lock *lock)
 	return lock->holder == thread_current();
 }
 
+/* Initializes RWLOCK.  A reader-writer lock can be held by any
+   number of readers at once, or by a single writer.
+
+   Writers are preferred: a writer first takes the internal
+   `writer' lock, which readers must also pass through on their
+   way in, and then waits for the readers already inside to
+   leave.  Readers arriving meanwhile queue up on `writer', so a
+   stream of readers cannot starve a writer, and because they
+   wait on an ordinary lock, they and any other writers donate
+   their priority to the writer.  Readers do not hold `writer'
+   while reading, so they run concurrently. */
+void rwlock_init(struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+
+	lock_init(&rwlock->writer);
+	rwlock->readers = 0;
+	rwlock->draining = false;
+	sema_init(&rwlock->drained, 0);
+}
+
+/* Acquires RWLOCK for reading, sleeping while a writer holds or
+   is waiting for it.  The current thread must not hold RWLOCK for
+   writing.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_read(struct rwlock *rwlock)
+{
+	enum intr_level old_level;
+
+	ASSERT(rwlock != NULL);
+	ASSERT(!intr_context());
+
+	lock_acquire(&rwlock->writer);
+	old_level = intr_disable();
+	rwlock->readers++;
+	intr_set_level(old_level);
+	lock_release(&rwlock->writer);
+}
+
+/* Releases read access to RWLOCK, letting a waiting writer in if
+   this was the last reader. */
+void rwlock_release_read(struct rwlock *rwlock)
+{
+	enum intr_level old_level;
+
+	ASSERT(rwlock != NULL);
+
+	old_level = intr_disable();
+	ASSERT(rwlock->readers > 0);
+	if (--rwlock->readers == 0 && rwlock->draining)
+		sema_up(&rwlock->drained);
+	intr_set_level(old_level);
+}
+
+/* Acquires RWLOCK for writing, sleeping until no other thread
+   holds it.  The current thread must not already hold RWLOCK.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_write(struct rwlock *rwlock)
+{
+	enum intr_level old_level;
+
+	ASSERT(rwlock != NULL);
+	ASSERT(!intr_context());
+
+	lock_acquire(&rwlock->writer);
+	old_level = intr_disable();
+	rwlock->draining = true;
+	while (rwlock->readers > 0)
+		sema_down(&rwlock->drained);
+	rwlock->draining = false;
+	intr_set_level(old_level);
+}
+
+/* Releases RWLOCK, which the current thread must hold for
+   writing. */
+void rwlock_release_write(struct rwlock *rwlock)
+{
+	ASSERT(rwlock_held_for_write(rwlock));
+
+	lock_release(&rwlock->writer);
+}
+
+/* Returns true if the current thread holds RWLOCK for writing,
+   false otherwise. */
+bool rwlock_held_for_write(const struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+
+	return lock_held_by_current_thread(&rwlock->writer);
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem {
 	struct list_elem elem;		/* List element. */
@@ -377,9 +490,65 @@ static bool cond_insert_by_priority(struct list_elem *cur UNUSED, struct list_el
 	return !list_empty(&sema_elem->semaphore.waiters);
 }
 
-static bool donor_higher_priority(struct list_elem *e1, struct list_elem *e2, void *aux UNUSED)
+/* Orders the waiters of a lock by priority. */
+static bool donor_higher_priority(const struct heap_elem *a, const struct heap_elem *b,
+								  void *aux UNUSED)
+{
+	return heap_entry(a, struct thread, donor_elem)->priority
+		   > heap_entry(b, struct thread, donor_elem)->priority;
+}
+
+/* Orders the locks a thread holds by the priority of their top
+   waiters. */
+static bool lock_higher_priority(const struct heap_elem *a, const struct heap_elem *b,
+								 void *aux UNUSED)
+{
+	return lock_top_priority(heap_entry(a, struct lock, holder_elem))
+		   > lock_top_priority(heap_entry(b, struct lock, holder_elem));
+}
+
+/* Returns the priority of LOCK's highest-priority waiter, or -1
+   if nothing waits for LOCK. */
+static int lock_top_priority(const struct lock *lock)
+{
+	struct heap_elem *top = heap_top(&lock->waiters);
+
+	return top != NULL ? heap_entry(top, struct thread, donor_elem)->priority : -1;
+}
+
+/* Passes a change in the top waiter of LOCK on to its holder,
+   and from there up the chain of holders waiting for other
+   locks, at most MAX_DEPTH levels.  Each level reorders one heap
+   entry, so this is O(log n) per level.  Stops early once a
+   holder's priority stays the same.  Interrupts must be off. */
+static void lock_donate(struct lock *lock)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (int depth = 0; lock != NULL && lock->holder != NULL && depth < MAX_DEPTH; depth++) {
+		struct thread *holder = lock->holder;
+		int priority;
+
+		heap_update(&holder->held_locks, &lock->holder_elem);
+		priority = lock_donated_priority(holder);
+		if (priority <= holder->priority)
+			break;
+
+		thread_update_priority(holder, priority);
+		lock = holder->waiting_lock;
+		if (lock != NULL)
+			heap_update(&lock->waiters, &holder->donor_elem);
+	}
+}
+
+/* Makes T the holder of LOCK.  Threads still waiting for LOCK now
+   donate to T.  Interrupts must be off. */
+static void lock_take(struct lock *lock, struct thread *t)
 {
-	struct thread *thread1 = list_entry(e1, struct thread, donor_elem);
-	struct thread *thread2 = list_entry(e2, struct thread, donor_elem);
-	return thread1->priority > thread2->priority;
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	lock->holder = t;
+	heap_push(&t->held_locks, &lock->holder_elem);
+	if (!thread_mlfqs && lock_top_priority(lock) > t->priority)
+		thread_update_priority(t, lock_top_priority(lock));
 }
@@ -14,6 +14,8 @@
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #ifdef USERPROG
@@ -29,11 +31,52 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-static struct list sleep_list;
+#if PRI_MAX - PRI_MIN >= 64
+#error ready_bitmap requires at most 64 priority levels
+#endif
+
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  There is one FIFO per
+   priority level, and bit P of ready_bitmap is set iff
+   ready_queues[P] is nonempty, so the highest runnable priority
+   is found with a single bit scan.
+
+   Under the fair-share scheduler the FIFOs stay empty and ready
+   threads are kept instead in fair_ready, a min-heap on vruntime.
+
+   Real-time threads are kept apart in rt_ready, a min-heap on
+   deadline, and always run before the other threads. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_bitmap;
+static size_t ready_cnt; /* # of ready threads, in all of the above. */
+
+static struct heap fair_ready;			/* Threads by vruntime (fair scheduler). */
+static int64_t fair_min_vruntime;		/* Never-decreasing floor of vruntimes. */
+static unsigned long fair_ready_weight; /* Sum of weights in fair_ready. */
+
+static struct heap rt_ready; /* Real-time threads by deadline. */
+
+/* Threads blocked in thread_sleep(), as a min-heap on
+   wakeup_tick, so the timer interrupt reads the next deadline in
+   constant time and only touches threads that are due. */
+static struct heap sleep_heap;
 static struct list all_list;
+
+/* Threads by tid, from allocate_tid() until thread_exit(), in
+   chained hash buckets.  Tids are handed out sequentially, so
+   `tid % TID_BUCKETS' spreads them evenly.  The chains are
+   intrusive, so the table never allocates and can be used with
+   interrupts off, which is also what protects it. */
+#define TID_BUCKETS 256
+static struct list tid_table[TID_BUCKETS];
+#ifdef USERPROG
+/* child_info records by tid, from thread_create() until the
+   parent reaps them in process_wait(). */
+static struct list child_table[TID_BUCKETS];
+
+/* Cache of child_info records. */
+static struct kmem_cache child_info_cache;
+#endif
 /* Idle thread. */
 static struct thread *idle_thread;
 
@@ -46,20 +89,101 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* Pages of dead threads kept for reuse by thread_create(), so
+   that creating a thread neither zeroes a page nor scans the
+   page allocator's bitmap.  init_thread() re-initializes the
+   whole struct thread, and the rest of the page is stack, which
+   needs no clearing.  Protected by disabling interrupts. */
+#define THREAD_CACHE_MAX 32
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+
 /* Statistics. */
 static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;   /* # of timer ticks in user programs. */
+static struct sched_stats sched_stats; /* Scheduling latency of all threads. */
 
 /* Scheduling. */
 #define TIME_SLICE 4		  /* # of timer ticks to give each thread. */
 static unsigned thread_ticks; /* # of timer ticks since last yield. */
+static unsigned thread_slice = TIME_SLICE; /* Length of this time slice. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler.
+   Controlled by kernel command-line option "-o fair". */
+bool thread_fair;
+
+/* Fair-share scheduler.
+
+   Each thread accumulates vruntime, its CPU time scaled by
+   NICE_0_WEIGHT / weight, where the weight follows from its nice
+   value; a thread 5 nice levels lower gets about 3 times the CPU.
+   The ready thread with the least vruntime runs next, for a time
+   slice that is its share of FAIR_LATENCY, so slices shrink as
+   the load grows.  A thread waking from a sleep is placed at
+   most FAIR_SLEEPER_CREDIT behind the queue's minimum, so it runs
+   soon but cannot bank sleep time to starve the others. */
+#define NICE_0_WEIGHT 1024
+#define VRUNTIME_TICK 1024 /* vruntime of one tick at nice 0. */
+#define FAIR_LATENCY 8	   /* Ticks in which every ready thread runs. */
+#define FAIR_MIN_SLICE 1   /* Shortest time slice, in ticks. */
+#define FAIR_WAKEUP_GRAN VRUNTIME_TICK
+#define FAIR_SLEEPER_CREDIT (FAIR_LATENCY / 2 * VRUNTIME_TICK)
+
+/* Weight of each nice value from -20 to 20.  Consecutive values
+   differ by about 1.25x. */
+static const unsigned long fair_weights[41] = {
+	/* -20 */ 88761, 71755, 56483, 46273, 36291,
+	/* -15 */ 29154, 23254, 18705, 14949, 11916,
+	/* -10 */ 9548, 7620, 6100, 4904, 3906,
+	/*  -5 */ 3121, 2501, 1991, 1586, 1277,
+	/*   0 */ 1024, 820, 655, 526, 423,
+	/*   5 */ 335, 272, 215, 172, 137,
+	/*  10 */ 110, 87, 70, 56, 45,
+	/*  15 */ 36, 29, 23, 18, 15,
+	/*  20 */ 12,
+};
+
+static unsigned long fair_weight(const struct thread *);
+static bool fair_less(const struct heap_elem *a, const struct heap_elem *b, void *aux);
+static void fair_place(struct thread *);
+static bool fair_should_preempt(const struct thread *);
+static unsigned fair_time_slice(const struct thread *);
+
+/* Earliest-deadline-first real-time class.
+
+   thread_set_deadline() gives a thread a period and a budget of
+   CPU ticks per period, and the ready real-time thread with the
+   earliest deadline, the end of its current period, runs ahead
+   of every other thread.  A thread that uses up its budget is
+   throttled: it sleeps until its deadline and then starts the
+   next period with a full budget.  Still being ready or running
+   when the period ends counts as a deadline miss; using up the
+   budget before then does not, since the thread got all the time
+   it reserved.
+
+   New threads are admitted only while the total utilization,
+   the sum of budget / period, stays within RT_UTIL_MAX, so that
+   EDF can meet every deadline and normal threads are not starved
+   completely. */
+#define RT_UTIL_SCALE 1000 /* Utilization of a thread that never sleeps. */
+#define RT_UTIL_MAX 950
+/* Longest period accepted, so that utilization arithmetic on a
+   period and a budget no longer than it cannot overflow. */
+#define RT_PERIOD_MAX (INT64_MAX / (RT_UTIL_SCALE + 1))
+static int64_t rt_util; /* Total utilization of admitted threads. */
+
+static bool rt_less(const struct heap_elem *a, const struct heap_elem *b, void *aux);
+static int64_t rt_utilization(const struct thread *);
+static void rt_new_period(struct thread *, int64_t now);
+static void rt_record_miss(struct thread *);
+static bool thread_should_preempt(const struct thread *);
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -67,17 +191,46 @@ static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
-static tid_t allocate_tid(void);
+static void thread_launch(void) NO_RETURN;
+static tid_t allocate_tid(struct thread *);
+static struct list *tid_bucket(struct list *table, tid_t);
+static struct thread *thread_page_alloc(void);
+static void thread_page_free(struct thread *);
+
+static void sched_account_switch(struct thread *curr, struct thread *next);
+static void sched_hist_add(struct sched_hist *, uint64_t cycles);
+static void sched_hist_print(const char *name, const struct sched_hist *);
+
+static bool sleep_heap_less(const struct heap_elem *a, const struct heap_elem *b, void *aux);
 
-static bool sleep_list_order(const struct list_elem *e1, const struct list_elem *e2, void *aux);
+static void ready_queue_push(struct thread *t);
+static void ready_queue_remove(struct thread *t);
+static struct thread *ready_queue_pop(void);
+static int ready_queue_max_priority(void);
 
 static fixed_t load_avg;
 
+/* Lazy recent_cpu decay.  Instead of decaying every thread once
+   per second, we remember the decay coefficient of each of the
+   last DECAY_HISTORY seconds and let each thread catch up on the
+   seconds it missed (see mlfqs_update_recent_cpu()) when it is
+   next queued or sampled. */
+#define DECAY_HISTORY 64
+static int64_t mlfqs_seconds;				 /* # of seconds since boot. */
+static fixed_t decay_coeff[DECAY_HISTORY]; /* Coefficient of second S at S % DECAY_HISTORY. */
+
+static void mlfqs_refresh(struct thread *t);
 static void mlfqs_update_priority(struct thread *t);
 static void mlfqs_update_recent_cpu(struct thread *t);
 static void mlfqs_update_load_avg(void);
-static void mlfqs_update_recent_cpu_all(void);
-static void mlfqs_update_priority_all(void);
+static void mlfqs_record_decay(void);
+
+/* Per-tick MLFQS bookkeeping, deferred out of the timer
+   interrupt.  mlfqs_seconds_due counts seconds that have started
+   but not yet been recorded. */
+static struct softirq mlfqs_softirq;
+static int mlfqs_seconds_due;
+static void mlfqs_tick(void *aux);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -119,18 +272,40 @@ void thread_init(void)
 
 	/* Init the globla thread context */
 	lock_init(&tid_lock);
-	list_init(&ready_list);
+	for (int i = PRI_MIN; i <= PRI_MAX; i++)
+		list_init(&ready_queues[i]);
+	ready_bitmap = 0;
+	ready_cnt = 0;
+	heap_init(&fair_ready, fair_less, NULL);
+	fair_min_vruntime = 0;
+	fair_ready_weight = 0;
+	heap_init(&rt_ready, rt_less, NULL);
 	list_init(&destruction_req);
+	list_init(&thread_cache);
 	list_init(&all_list);
+	for (int i = 0; i < TID_BUCKETS; i++) {
+		list_init(&tid_table[i]);
+#ifdef USERPROG
+		list_init(&child_table[i]);
+#endif
+	}
+#ifdef USERPROG
+	kmem_cache_init(&child_info_cache, "child_info", sizeof(struct child_info), 0, NULL);
+#endif
+
+	if (thread_mlfqs && thread_fair)
+		PANIC("-mlfqs and -fair are mutually exclusive");
 
 	load_avg = FP_CONST(0);
+	softirq_init(&mlfqs_softirq, mlfqs_tick, NULL);
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread();
 	init_thread(initial_thread, "main", PRI_DEFAULT);
 	initial_thread->status = THREAD_RUNNING;
-	initial_thread->tid = allocate_tid();
+	allocate_tid(initial_thread);
+	initial_thread->sched_dispatched = rdtsc();
 
-	list_init(&sleep_list);
+	heap_init(&sleep_heap, sleep_heap_less, NULL);
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -169,16 +344,29 @@ void thread_tick(void)
 		if (t != idle_thread)
 			t->recent_cpu = FP_ADD_MIXED(t->recent_cpu, 1);
 
-		if (timer_ticks() % TIMER_FREQ == 0) {
-			mlfqs_update_load_avg();
-			mlfqs_update_recent_cpu_all();
+		bool new_second = timer_ticks() % TIMER_FREQ == 0;
+		if (new_second)
+			mlfqs_seconds_due++;
+		if (new_second || timer_ticks() % 4 == 0)
+			softirq_raise(&mlfqs_softirq);
+	}
+
+	if (t->rt_period != 0) {
+		int64_t now = timer_ticks();
+
+		if (now >= t->rt_deadline) {
+			rt_record_miss(t);
+			rt_new_period(t, now);
+			intr_yield_on_return();
+		} else if (--t->rt_runtime <= 0) {
+			t->rt_throttled = true;
+			intr_yield_on_return();
 		}
+	} else if (thread_fair && t != idle_thread)
+		t->vruntime += VRUNTIME_TICK * NICE_0_WEIGHT / fair_weight(t);
 
-		if (timer_ticks() % 4 == 0)
-			mlfqs_update_priority_all();
-	}
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (++thread_ticks >= thread_slice)
 		intr_yield_on_return();
 }
 
@@ -187,6 +375,11 @@ void thread_print_stats(void)
 {
 	printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks,
 		   kernel_ticks, user_ticks);
+	printf("Sched: %llu voluntary, %llu involuntary switches, %llu deadline misses\n",
+		   sched_stats.voluntary, sched_stats.involuntary, sched_stats.deadline_misses);
+	sched_hist_print("run-queue wait", &sched_stats.run_wait);
+	sched_hist_print("wakeup", &sched_stats.wakeup);
+	sched_hist_print("time slice", &sched_stats.slice);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -207,26 +400,36 @@ void thread_print_stats(void)
 tid_t thread_create(const char *name, int priority, thread_func *function, void *aux)
 {
 	struct thread *parent_t = thread_current();
+	struct switch_threads_frame *frame;
+	enum intr_level old_level UNUSED;
 	struct thread *t;
 	tid_t tid;
 
 	ASSERT(function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page(PAL_ZERO);
+	t = thread_page_alloc();
 	if (t == NULL)
 		return TID_ERROR;
 
 	/* Initialize thread. */
 	init_thread(t, name, priority);
-	tid = t->tid = allocate_tid();
+	tid = allocate_tid(t);
 
 	if (thread_mlfqs) {
+		mlfqs_update_recent_cpu(parent_t);
 		t->nice = parent_t->nice;
 		t->recent_cpu = parent_t->recent_cpu;
+		t->recent_cpu_sec = mlfqs_seconds;
 		mlfqs_update_priority(t);
 	}
 
+	/* Start fair-share threads level with the ready threads. */
+	if (thread_fair) {
+		t->nice = parent_t->nice;
+		t->vruntime = fair_min_vruntime;
+	}
+
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
 	t->tf.rip = (uintptr_t)kernel_thread;
@@ -238,13 +441,25 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
 	t->tf.cs = SEL_KCSEG;
 	t->tf.eflags = FLAG_IF;
 
+	/* Make the first switch_threads() into T "return" to
+	   thread_launch().  The frame sits at the top of T's stack,
+	   with the return address placed so that thread_launch() sees
+	   the stack alignment of a normal call. */
+	frame = (struct switch_threads_frame *)((uint8_t *)t + PGSIZE - sizeof(void *)) - 1;
+	frame->rip = thread_launch;
+	t->switch_rsp = (uintptr_t)frame;
+
 #ifdef USERPROG
-	t->my_entry = calloc(1, sizeof(struct child_info));
+	t->my_entry = kmem_cache_zalloc(&child_info_cache);
 	sema_init(&t->my_entry->wait_sema, 0);
 	t->my_entry->tid = tid;
+	t->my_entry->parent_tid = parent_t->tid;
 	t->my_entry->wait = false;
 	t->my_entry->exit_status = -1;
 	list_push_front(&parent_t->child_list, &t->my_entry->child_elem);
+	old_level = intr_disable();
+	list_push_back(tid_bucket(child_table, tid), &t->my_entry->tid_elem);
+	intr_set_level(old_level);
 #endif
 
 	list_push_back(&all_list, &t->allelem);
@@ -264,6 +479,7 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
 void thread_block(void)
 {
 	ASSERT(!intr_context());
+	ASSERT(!softirq_context());
 	ASSERT(intr_get_level() == INTR_OFF);
 	thread_current()->status = THREAD_BLOCKED;
 	schedule();
@@ -285,11 +501,25 @@ void thread_unblock(struct thread *t)
 
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
+	if (thread_mlfqs)
+		mlfqs_refresh(t);
+	if (thread_fair)
+		fair_place(t);
+	if (t->rt_period != 0) {
+		/* A throttled thread wakes at its deadline; any other
+		   thread waking after its deadline starts afresh. */
+		int64_t now = timer_ticks();
+		t->rt_throttled = false;
+		if (now >= t->rt_deadline)
+			rt_new_period(t, now);
+	}
 	t->status = THREAD_READY;
-	list_push_front(&ready_list, &t->elem);
+	t->sched_woken = true;
+	t->sched_enqueued = rdtsc();
+	ready_queue_push(t);
 	intr_set_level(old_level);
-	if (t->priority > thread_current()->priority) {
-		if (intr_context())
+	if (thread_should_preempt(t)) {
+		if (intr_context() || softirq_context())
 			intr_yield_on_return();
 		else
 			thread_yield();
@@ -326,6 +556,63 @@ tid_t thread_tid(void)
 	return thread_current()->tid;
 }
 
+/* Returns the thread whose tid is TID, or a null pointer if
+   there is no such thread or it has exited. */
+struct thread *thread_lookup(tid_t tid)
+{
+	struct list *bucket = tid_bucket(tid_table, tid);
+	enum intr_level old_level = intr_disable();
+	struct thread *found = NULL;
+
+	for (struct list_elem *e = list_begin(bucket); e != list_end(bucket); e = list_next(e)) {
+		struct thread *t = list_entry(e, struct thread, tid_elem);
+		if (t->tid == tid) {
+			found = t;
+			break;
+		}
+	}
+	intr_set_level(old_level);
+	return found;
+}
+
+#ifdef USERPROG
+/* Returns the child_info of the running thread's child TID, or a
+   null pointer if TID is not a child of the running thread or
+   has already been reaped. */
+struct child_info *thread_find_child(tid_t tid)
+{
+	struct list *bucket = tid_bucket(child_table, tid);
+	enum intr_level old_level = intr_disable();
+	struct child_info *found = NULL;
+
+	for (struct list_elem *e = list_begin(bucket); e != list_end(bucket); e = list_next(e)) {
+		struct child_info *c = list_entry(e, struct child_info, tid_elem);
+		if (c->tid == tid) {
+			if (c->parent_tid == thread_tid())
+				found = c;
+			break;
+		}
+	}
+	intr_set_level(old_level);
+	return found;
+}
+
+/* Removes CHILD, a child_info of the running thread, from its
+   lists and frees it. */
+void thread_reap_child(struct child_info *child)
+{
+	enum intr_level old_level;
+
+	ASSERT(child->parent_tid == thread_tid());
+
+	list_remove(&child->child_elem);
+	old_level = intr_disable();
+	list_remove(&child->tid_elem);
+	intr_set_level(old_level);
+	kmem_cache_free(&child_info_cache, child);
+}
+#endif
+
 /* Deschedules the current thread and destroys it.  Never
    returns to the caller. */
 void thread_exit(void)
@@ -340,6 +627,8 @@ void thread_exit(void)
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable();
 	list_remove(&thread_current()->allelem);
+	list_remove(&thread_current()->tid_elem);
+	rt_util -= rt_utilization(thread_current());
 	do_schedule(THREAD_DYING);
 	NOT_REACHED();
 }
@@ -352,17 +641,29 @@ void thread_yield(void)
 	enum intr_level old_level;
 
 	ASSERT(!intr_context());
+	ASSERT(!softirq_context());
 
 	old_level = intr_disable();
-	if (curr != idle_thread)
-		list_push_front(&ready_list, &curr->elem);
-	do_schedule(THREAD_READY);
+	if (curr->rt_throttled) {
+		/* Out of budget: sleep until the next period. */
+		curr->wakeup_tick = curr->rt_deadline;
+		heap_push(&sleep_heap, &curr->sleep_elem);
+		do_schedule(THREAD_BLOCKED);
+	} else {
+		if (curr != idle_thread) {
+			if (thread_mlfqs)
+				mlfqs_refresh(curr);
+			curr->sched_enqueued = rdtsc();
+			ready_queue_push(curr);
+		}
+		do_schedule(THREAD_READY);
+	}
 	intr_set_level(old_level);
 }
 
 /// @brief
 /// 현재 스레드를 지정된 시간까지 재운다.
-/// 스레드는 sleep_list에 추가되고, wakeup_tick이 도달할 때까지 BLOCKED 상태로 전환된다.
+/// 스레드는 sleep_heap에 추가되고, wakeup_tick이 도달할 때까지 BLOCKED 상태로 전환된다.
 ///
 /// @param wakeup_tick
 /// 스레드가 다시 깨어날 시점의 절대 tick 값 (`timer_ticks() + ticks`)
@@ -372,7 +673,7 @@ void thread_sleep(int64_t wakeup_tick)
 
 	struct thread *cur_thread = thread_current();
 	cur_thread->wakeup_tick = wakeup_tick;
-	list_insert_ordered(&sleep_list, &cur_thread->elem, sleep_list_order, NULL);
+	heap_push(&sleep_heap, &cur_thread->sleep_elem);
 	thread_block();
 
 	intr_set_level(old_level);
@@ -380,18 +681,27 @@ void thread_sleep(int64_t wakeup_tick)
 
 /// @brief
 /// 현재 시각(ticks)에 도달한 스레드들을 깨워 READY 상태로 전환한다.
-/// (sleep_list의 맨 앞부터 검사하며, wakeup_tick이 아직 안 된 스레드는 남겨둔다.)
+/// (sleep_heap의 top부터 검사하며, wakeup_tick이 아직 안 된 스레드는 남겨둔다.)
+/// 인터럽트는 스레드 하나를 깨울 때마다 잠깐씩만 끈다.
 void wake_sleeping_threads(int64_t tick)
 {
-	enum intr_level old_level = intr_disable();
-	while (!list_empty(&sleep_list)) {
-		struct thread *cur_thread = list_entry(list_front(&sleep_list), struct thread, elem);
-		if (cur_thread->wakeup_tick > tick)
+	for (;;) {
+		enum intr_level old_level = intr_disable();
+		struct thread *cur_thread = NULL;
+
+		if (!heap_empty(&sleep_heap)) {
+			cur_thread = heap_entry(heap_top(&sleep_heap), struct thread, sleep_elem);
+			if (cur_thread->wakeup_tick <= tick) {
+				heap_pop(&sleep_heap);
+				thread_unblock(cur_thread);
+			} else
+				cur_thread = NULL;
+		}
+		intr_set_level(old_level);
+
+		if (cur_thread == NULL)
 			break;
-		list_pop_front(&sleep_list);
-		thread_unblock(cur_thread);
 	}
-	intr_set_level(old_level);
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
@@ -403,17 +713,49 @@ void thread_set_priority(int new_priority)
 	enum intr_level old_level = intr_disable();
 	struct thread *t = thread_current();
 	t->base_priority = new_priority;
-	if (list_empty(&thread_current()->donor_list))
+	t->priority = lock_donated_priority(t);
+	if (t->priority < new_priority)
 		t->priority = new_priority;
 
-	if (!list_empty(&ready_list) &&
-		(new_priority <
-		 list_entry(list_max(&ready_list, thread_priority_max, NULL), struct thread, elem)
-			 ->priority))
+	if (t->priority < ready_queue_max_priority())
 		thread_yield();
 	intr_set_level(old_level);
 }
 
+/* Puts the current thread in the real-time class, to run for up
+   to BUDGET ticks in every PERIOD ticks, starting now, or takes
+   it out of the class if PERIOD is 0.  Returns false, changing
+   nothing, if the arguments are invalid or admitting the thread
+   would overcommit the CPU. */
+bool thread_set_deadline(int64_t period, int64_t budget)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+	int64_t util;
+
+	if (period < 0 || period > RT_PERIOD_MAX || budget < 0 || budget > period ||
+		(period != 0 && budget == 0))
+		return false;
+
+	old_level = intr_disable();
+	util = period != 0 ? DIV_ROUND_UP(budget * RT_UTIL_SCALE, period) : 0;
+	if (rt_util - rt_utilization(curr) + util > RT_UTIL_MAX) {
+		intr_set_level(old_level);
+		return false;
+	}
+	rt_util += util - rt_utilization(curr);
+	curr->rt_period = period;
+	curr->rt_budget = budget;
+	curr->rt_throttled = false;
+	if (period != 0)
+		rt_new_period(curr, timer_ticks());
+	intr_set_level(old_level);
+
+	/* Let the scheduler pick again under the new class. */
+	thread_yield();
+	return true;
+}
+
 /* Returns the current thread's priority. */
 int thread_get_priority(void)
 {
@@ -426,15 +768,20 @@ void thread_set_nice(int nice)
 	ASSERT(nice >= -20 && nice <= 20);
 
 	enum intr_level old_level = intr_disable();
+	if (thread_fair) {
+		/* Only the weight changes, which takes effect at the next
+		   tick charged to this thread. */
+		thread_current()->nice = nice;
+		intr_set_level(old_level);
+		return;
+	}
+
+	mlfqs_update_recent_cpu(thread_current());
 	thread_current()->nice = nice;
 	mlfqs_update_priority(thread_current());
 
-	if (!list_empty(&ready_list)) {
-		struct thread *max_ready =
-			list_entry(list_max(&ready_list, thread_priority_max, NULL), struct thread, elem);
-		if (thread_current()->priority < max_ready->priority)
-			thread_yield();
-	}
+	if (thread_current()->priority < ready_queue_max_priority())
+		thread_yield();
 	intr_set_level(old_level);
 }
 
@@ -460,6 +807,7 @@ int thread_get_load_avg(void)
 int thread_get_recent_cpu(void)
 {
 	enum intr_level old_level = intr_disable();
+	mlfqs_update_recent_cpu(thread_current());
 	int recent = FP_TO_INT_ROUND(FP_MUL_MIXED(thread_current()->recent_cpu, 100));
 	intr_set_level(old_level);
 	return recent;
@@ -486,6 +834,17 @@ static void idle(void *idle_started_ UNUSED)
 		intr_disable();
 		thread_block();
 
+		/* Nothing else is ready, so zero pages for later.  An
+		   interrupt that wakes a thread may preempt us between
+		   pages as usual; one that wakes a thread that cannot
+		   preempt the idle thread is caught by the check. */
+		intr_enable();
+		while (ready_cnt == 0 && palloc_zero_ahead())
+			continue;
+		intr_disable();
+		if (ready_cnt != 0)
+			continue;
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -530,7 +889,7 @@ static void init_thread(struct thread *t, const char *name, int priority)
 
 	t->base_priority = priority;
 	t->waiting_lock = NULL;
-	list_init(&t->donor_list);
+	lock_init_holder(t);
 
 	t->nice = 0;
 	t->recent_cpu = FP_CONST(0);
@@ -549,13 +908,10 @@ static void init_thread(struct thread *t, const char *name, int priority)
    idle_thread. */
 static struct thread *next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
+	if (ready_cnt == 0)
 		return idle_thread;
-	else {
-		struct list_elem *max_elem = list_max(&ready_list, thread_priority_max, NULL);
-		list_remove(max_elem);
-		return list_entry(max_elem, struct thread, elem);
-	}
+	else
+		return ready_queue_pop();
 }
 
 /* Use iretq to launch the thread */
@@ -587,74 +943,16 @@ void do_iret(struct intr_frame *tf)
 					 : "memory");
 }
 
-/* Switching the thread by activating the new thread's page
-   tables, and, if the previous thread is dying, destroying it.
-
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
-
-   It's not safe to call printf() until the thread switch is
-   complete.  In practice that means that printf()s should be
-   added at the end of the function. */
-static void thread_launch(struct thread *th)
+/* First code run by a newly created thread, entered through the
+   `ret' of switch_threads() in place of a return into
+   schedule().  Loads the thread's initial intr_frame, set up by
+   thread_create(), with iretq so that it starts in
+   kernel_thread() with interrupts enabled. */
+static void thread_launch(void)
 {
-	uint64_t tf_cur = (uint64_t)&running_thread()->tf;
-	uint64_t tf = (uint64_t)&th->tf;
 	ASSERT(intr_get_level() == INTR_OFF);
-
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile(
-		/* Store registers that will be used. */
-		"push %%rax\n"
-		"push %%rbx\n"
-		"push %%rcx\n"
-		/* Fetch input once */
-		"movq %0, %%rax\n"
-		"movq %1, %%rcx\n"
-		"movq %%r15, 0(%%rax)\n"
-		"movq %%r14, 8(%%rax)\n"
-		"movq %%r13, 16(%%rax)\n"
-		"movq %%r12, 24(%%rax)\n"
-		"movq %%r11, 32(%%rax)\n"
-		"movq %%r10, 40(%%rax)\n"
-		"movq %%r9, 48(%%rax)\n"
-		"movq %%r8, 56(%%rax)\n"
-		"movq %%rsi, 64(%%rax)\n"
-		"movq %%rdi, 72(%%rax)\n"
-		"movq %%rbp, 80(%%rax)\n"
-		"movq %%rdx, 88(%%rax)\n"
-		"pop %%rbx\n" // Saved rcx
-		"movq %%rbx, 96(%%rax)\n"
-		"pop %%rbx\n" // Saved rbx
-		"movq %%rbx, 104(%%rax)\n"
-		"pop %%rbx\n" // Saved rax
-		"movq %%rbx, 112(%%rax)\n"
-		"addq $120, %%rax\n"
-		"movw %%es, (%%rax)\n"
-		"movw %%ds, 8(%%rax)\n"
-		"addq $32, %%rax\n"
-		"call __next\n" // read the current rip.
-		"__next:\n"
-		"pop %%rbx\n"
-		"addq $(out_iret -  __next), %%rbx\n"
-		"movq %%rbx, 0(%%rax)\n" // rip
-		"movw %%cs, 8(%%rax)\n"	 // cs
-		"pushfq\n"
-		"popq %%rbx\n"
-		"mov %%rbx, 16(%%rax)\n" // eflags
-		"mov %%rsp, 24(%%rax)\n" // rsp
-		"movw %%ss, 32(%%rax)\n"
-		"mov %%rcx, %%rdi\n"
-		"call do_iret\n"
-		"out_iret:\n"
-		:
-		: "g"(tf_cur), "g"(tf)
-		: "memory");
+	do_iret(&thread_current()->tf);
+	NOT_REACHED();
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -667,7 +965,7 @@ static void do_schedule(int status)
 	ASSERT(thread_current()->status == THREAD_RUNNING);
 	while (!list_empty(&destruction_req)) {
 		struct thread *victim = list_entry(list_pop_front(&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		thread_page_free(victim);
 	}
 	thread_current()->status = status;
 	schedule();
@@ -683,9 +981,13 @@ static void schedule(void)
 	ASSERT(is_thread(next));
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
+	sched_account_switch(curr, next);
 
 	/* Start new time slice. */
 	thread_ticks = 0;
+	thread_slice = TIME_SLICE;
+	if (thread_fair && next != idle_thread && next->rt_period == 0)
+		thread_slice = fair_time_slice(next);
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -705,41 +1007,349 @@ static void schedule(void)
 			list_push_back(&destruction_req, &curr->elem);
 		}
 
-		/* Before switching the thread, we first save the information
-		 * of current running. */
-		thread_launch(next);
+		/* Save our callee-saved registers and resume NEXT.  We
+		 * return here when some later schedule() switches back. */
+		switch_threads(&curr->switch_rsp, next->switch_rsp);
+	}
+}
+
+/* Copies the scheduling statistics selected by SCOPE into
+   *STATS.  Returns false if SCOPE is invalid. */
+bool thread_get_sched_stats(enum sched_stats_scope scope, struct sched_stats *stats)
+{
+	enum intr_level old_level = intr_disable();
+	bool success = true;
+
+	if (scope == SCHED_STATS_SELF)
+		*stats = thread_current()->sched_stats;
+	else if (scope == SCHED_STATS_SYSTEM)
+		*stats = sched_stats;
+	else
+		success = false;
+	intr_set_level(old_level);
+	return success;
+}
+
+/* Charges the switch from CURR to NEXT to both threads' and the
+   system-wide statistics: CURR's time slice and the reason it
+   gave up the CPU, NEXT's wait in the run queue.  The idle
+   thread is not accounted. */
+static void sched_account_switch(struct thread *curr, struct thread *next)
+{
+	uint64_t now = rdtsc();
+
+	if (curr != idle_thread) {
+		uint64_t used = now - curr->sched_dispatched;
+
+		sched_hist_add(&curr->sched_stats.slice, used);
+		sched_hist_add(&sched_stats.slice, used);
+		if (curr->status == THREAD_READY) {
+			curr->sched_stats.involuntary++;
+			sched_stats.involuntary++;
+		} else {
+			curr->sched_stats.voluntary++;
+			sched_stats.voluntary++;
+		}
+	}
+
+	if (next != idle_thread) {
+		uint64_t waited = now - next->sched_enqueued;
+
+		sched_hist_add(&next->sched_stats.run_wait, waited);
+		sched_hist_add(&sched_stats.run_wait, waited);
+		if (next->sched_woken) {
+			sched_hist_add(&next->sched_stats.wakeup, waited);
+			sched_hist_add(&sched_stats.wakeup, waited);
+		}
+	}
+	next->sched_woken = false;
+	next->sched_dispatched = now;
+}
+
+/* Adds a sample of CYCLES to histogram H. */
+static void sched_hist_add(struct sched_hist *h, uint64_t cycles)
+{
+	uint64_t units = cycles >> SCHED_HIST_SHIFT;
+	int bucket = units != 0 ? 64 - __builtin_clzll(units) : 0;
+
+	if (bucket >= SCHED_HIST_BUCKETS)
+		bucket = SCHED_HIST_BUCKETS - 1;
+	h->count[bucket]++;
+}
+
+/* Prints the nonempty buckets of histogram H, labeled NAME. */
+static void sched_hist_print(const char *name, const struct sched_hist *h)
+{
+	printf("Sched %s (log2 of %d-cycle units):", name, 1 << SCHED_HIST_SHIFT);
+	for (int i = 0; i < SCHED_HIST_BUCKETS; i++)
+		if (h->count[i] != 0)
+			printf(" %d:%u", i, h->count[i]);
+	printf("\n");
+}
+
+/* Returns a page for a new thread, from the cache of dead
+   threads' pages if possible.  The page is not zeroed.  Returns a
+   null pointer if no page is available. */
+static struct thread *thread_page_alloc(void)
+{
+	struct thread *t = NULL;
+	enum intr_level old_level = intr_disable();
+
+	if (!list_empty(&thread_cache)) {
+		t = list_entry(list_pop_front(&thread_cache), struct thread, elem);
+		thread_cache_cnt--;
 	}
+	intr_set_level(old_level);
+
+	return t != NULL ? t : palloc_get_page(0);
+}
+
+/* Releases the page of dead thread T, keeping it in the cache
+   unless the cache is full.  Interrupts must be off. */
+static void thread_page_free(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (thread_cache_cnt < THREAD_CACHE_MAX) {
+		list_push_front(&thread_cache, &t->elem);
+		thread_cache_cnt++;
+	} else
+		palloc_free_page(t);
 }
 
-/* Returns a tid to use for a new thread. */
-static tid_t allocate_tid(void)
+/* Assigns a tid to new thread T, enters T in the tid table, and
+   returns the tid. */
+static tid_t allocate_tid(struct thread *t)
 {
 	static tid_t next_tid = 1;
-	tid_t tid;
+	enum intr_level old_level;
 
 	lock_acquire(&tid_lock);
-	tid = next_tid++;
+	t->tid = next_tid++;
 	lock_release(&tid_lock);
 
-	return tid;
+	old_level = intr_disable();
+	list_push_back(tid_bucket(tid_table, t->tid), &t->tid_elem);
+	intr_set_level(old_level);
+
+	return t->tid;
+}
+
+/* Returns the bucket of TABLE that holds TID. */
+static struct list *tid_bucket(struct list *table, tid_t tid)
+{
+	return &table[(unsigned)tid % TID_BUCKETS];
 }
 
 /// @brief
-/// 두 스레드의 wakeup_tick 값을 비교하여 정렬 순서를 결정한다.
-/// (timer_sleep에서 list_insert_ordered()에 사용됨)
+/// 두 스레드의 wakeup_tick 값을 비교하여 sleep_heap의 순서를 결정한다.
 ///
-/// @param e1 첫 번째 리스트 요소의 포인터
-/// @param e2 두 번째 리스트 요소의 포인터
+/// @param a 첫 번째 힙 요소의 포인터
+/// @param b 두 번째 힙 요소의 포인터
 /// @param aux 추가 인자(사용하지 않음)
 /// @return
-/// e1의 wakeup_tick이 e2보다 작으면 true, 아니면 false
-static bool sleep_list_order(const struct list_elem *e1, const struct list_elem *e2, void *aux)
+/// a의 wakeup_tick이 b보다 작으면 true, 아니면 false
+static bool sleep_heap_less(const struct heap_elem *a, const struct heap_elem *b,
+							void *aux UNUSED)
 {
-	struct thread *thread1 = list_entry(e1, struct thread, elem);
-	struct thread *thread2 = list_entry(e2, struct thread, elem);
+	struct thread *thread1 = heap_entry(a, struct thread, sleep_elem);
+	struct thread *thread2 = heap_entry(b, struct thread, sleep_elem);
 	return thread1->wakeup_tick < thread2->wakeup_tick;
 }
 
+/* Sets T's effective priority to PRIORITY.  If T is sitting in a
+   ready queue it is moved to the queue for its new priority, so
+   callers that change the priority of a thread they do not own
+   (e.g. priority donation) must go through here. */
+void thread_update_priority(struct thread *t, int priority)
+{
+	enum intr_level old_level = intr_disable();
+
+	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+	if (!thread_fair && t->status == THREAD_READY && t->priority != priority) {
+		ready_queue_remove(t);
+		t->priority = priority;
+		ready_queue_push(t);
+	} else
+		t->priority = priority;
+	intr_set_level(old_level);
+}
+
+/* Appends T to the tail of the ready queue for its priority, or
+   inserts it by deadline if it is a real-time thread or by
+   vruntime under the fair-share scheduler.
+   Interrupts must be off. */
+static void ready_queue_push(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (t->rt_period != 0)
+		heap_push(&rt_ready, &t->rt_elem);
+	else if (thread_fair) {
+		heap_push(&fair_ready, &t->fair_elem);
+		fair_ready_weight += fair_weight(t);
+	} else {
+		list_push_back(&ready_queues[t->priority], &t->elem);
+		ready_bitmap |= 1ULL << t->priority;
+	}
+	ready_cnt++;
+}
+
+/* Removes T from the ready queues.
+   Interrupts must be off. */
+static void ready_queue_remove(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (t->rt_period != 0)
+		heap_remove(&rt_ready, &t->rt_elem);
+	else if (thread_fair) {
+		heap_remove(&fair_ready, &t->fair_elem);
+		fair_ready_weight -= fair_weight(t);
+	} else {
+		list_remove(&t->elem);
+		if (list_empty(&ready_queues[t->priority]))
+			ready_bitmap &= ~(1ULL << t->priority);
+	}
+	ready_cnt--;
+}
+
+/* Removes and returns the real-time thread with the earliest
+   deadline, if any, or else the thread at the head of the
+   highest nonempty ready queue, or under the fair-share scheduler
+   the thread with the least vruntime.  At least one thread must
+   be ready.
+   Interrupts must be off. */
+static struct thread *ready_queue_pop(void)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(ready_cnt != 0);
+
+	if (!heap_empty(&rt_ready)) {
+		struct thread *t = heap_entry(heap_pop(&rt_ready), struct thread, rt_elem);
+		int64_t now = timer_ticks();
+		if (now >= t->rt_deadline) {
+			rt_record_miss(t);
+			rt_new_period(t, now);
+		}
+		ready_cnt--;
+		return t;
+	}
+
+	if (thread_fair) {
+		struct thread *t = heap_entry(heap_pop(&fair_ready), struct thread, fair_elem);
+		fair_ready_weight -= fair_weight(t);
+		if (t->vruntime > fair_min_vruntime)
+			fair_min_vruntime = t->vruntime;
+		ready_cnt--;
+		return t;
+	}
+
+	int priority = ready_queue_max_priority();
+	struct thread *t = list_entry(list_pop_front(&ready_queues[priority]), struct thread, elem);
+	if (list_empty(&ready_queues[priority]))
+		ready_bitmap &= ~(1ULL << priority);
+	ready_cnt--;
+	return t;
+}
+
+/* Returns the highest priority among ready threads, or -1 if no
+   thread is ready. */
+static int ready_queue_max_priority(void)
+{
+	return ready_bitmap != 0 ? 63 - __builtin_clzll(ready_bitmap) : -1;
+}
+
+/* Returns the scheduling weight of T's nice value. */
+static unsigned long fair_weight(const struct thread *t)
+{
+	ASSERT(t->nice >= -20 && t->nice <= 20);
+	return fair_weights[t->nice + 20];
+}
+
+/* Orders threads by vruntime for the fair-share run queue. */
+static bool fair_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED)
+{
+	return heap_entry(a, struct thread, fair_elem)->vruntime
+		   < heap_entry(b, struct thread, fair_elem)->vruntime;
+}
+
+/* Moves T, which is waking up, no further than
+   FAIR_SLEEPER_CREDIT behind the run queue's minimum vruntime. */
+static void fair_place(struct thread *t)
+{
+	int64_t floor = fair_min_vruntime - FAIR_SLEEPER_CREDIT;
+
+	if (t->vruntime < floor)
+		t->vruntime = floor;
+}
+
+/* Returns true if T, which just became ready, should preempt the
+   running thread: it is behind the running thread by more than
+   FAIR_WAKEUP_GRAN, or the CPU is idle. */
+static bool fair_should_preempt(const struct thread *t)
+{
+	struct thread *curr = thread_current();
+
+	return curr == idle_thread || t->vruntime + FAIR_WAKEUP_GRAN < curr->vruntime;
+}
+
+/* Returns the length in ticks of the time slice for T, about to
+   run: T's share, by weight, of FAIR_LATENCY among T and the
+   threads still in the run queue. */
+static unsigned fair_time_slice(const struct thread *t)
+{
+	unsigned long weight = fair_weight(t);
+	unsigned slice = FAIR_LATENCY * weight / (fair_ready_weight + weight);
+
+	return slice > FAIR_MIN_SLICE ? slice : FAIR_MIN_SLICE;
+}
+
+/* Orders real-time threads by deadline. */
+static bool rt_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED)
+{
+	return heap_entry(a, struct thread, rt_elem)->rt_deadline
+		   < heap_entry(b, struct thread, rt_elem)->rt_deadline;
+}
+
+/* Returns T's share of the CPU in units of 1 / RT_UTIL_SCALE, or
+   0 if T is not a real-time thread. */
+static int64_t rt_utilization(const struct thread *t)
+{
+	if (t->rt_period == 0)
+		return 0;
+	return DIV_ROUND_UP(t->rt_budget * RT_UTIL_SCALE, t->rt_period);
+}
+
+/* Starts a new period for real-time thread T at tick NOW. */
+static void rt_new_period(struct thread *t, int64_t now)
+{
+	t->rt_deadline = now + t->rt_period;
+	t->rt_runtime = t->rt_budget;
+}
+
+/* Counts a missed deadline of T. */
+static void rt_record_miss(struct thread *t)
+{
+	t->sched_stats.deadline_misses++;
+	sched_stats.deadline_misses++;
+}
+
+/* Returns true if T, which just became ready, should preempt the
+   running thread.  Real-time threads preempt all others, and
+   each other by earlier deadline. */
+static bool thread_should_preempt(const struct thread *t)
+{
+	struct thread *curr = thread_current();
+
+	if (t->rt_period != 0 || curr->rt_period != 0)
+		return t->rt_period != 0
+			   && (curr->rt_period == 0 || t->rt_deadline < curr->rt_deadline);
+	if (thread_fair)
+		return fair_should_preempt(t);
+	return t->priority > curr->priority;
+}
+
 bool thread_priority_max(const struct list_elem *e1, const struct list_elem *e2, void *aux)
 {
 	struct thread *thread1 = list_entry(e1, struct thread, elem);
@@ -747,6 +1357,30 @@ bool thread_priority_max(const struct list_elem *e1, const struct list_elem *e2,
 	return thread1->priority <= thread2->priority;
 }
 
+/* Records the seconds that have started since the last run and
+   refreshes the running thread, which is still the thread that
+   was interrupted.  Every other thread is refreshed when it is
+   next queued.  Runs as a softirq raised by thread_tick(). */
+static void mlfqs_tick(void *aux UNUSED)
+{
+	enum intr_level old_level = intr_disable();
+
+	for (; mlfqs_seconds_due > 0; mlfqs_seconds_due--) {
+		mlfqs_update_load_avg();
+		mlfqs_record_decay();
+	}
+	mlfqs_refresh(thread_current());
+	intr_set_level(old_level);
+}
+
+/* Brings T's recent_cpu up to date and recomputes its priority
+   from it. */
+static void mlfqs_refresh(struct thread *t)
+{
+	mlfqs_update_recent_cpu(t);
+	mlfqs_update_priority(t);
+}
+
 static void mlfqs_update_priority(struct thread *t)
 {
 	if (t == idle_thread)
@@ -761,24 +1395,56 @@ static void mlfqs_update_priority(struct thread *t)
 	else if (new_priority < PRI_MIN)
 		new_priority = PRI_MIN;
 
-	t->priority = new_priority;
+	thread_update_priority(t, new_priority);
 }
 
+/* Applies to T every per-second decay it has missed since
+   recent_cpu_sec:
+   recent_cpu = (2*load_avg)/(2*load_avg + 1) * recent_cpu + nice
+
+   Seconds older than the history window are folded in with the
+   oldest coefficient still known, using the closed form of K
+   applications of x = c*x + nice, which is
+   e + c^K * (x - e) with e = nice / (1 - c) = nice * (2*load_avg + 1). */
 static void mlfqs_update_recent_cpu(struct thread *t)
 {
 	if (t == idle_thread)
 		return;
 
-	/* recent_cpu = (2*load_avg)/(2*load_avg + 1) * recent_cpu + nice */
-	fixed_t coeff = FP_DIV(FP_MUL_MIXED(load_avg, 2), FP_ADD_MIXED(FP_MUL_MIXED(load_avg, 2), 1));
+	int64_t missed = mlfqs_seconds - t->recent_cpu_sec;
+	if (missed <= 0)
+		return;
+
+	if (missed > DECAY_HISTORY) {
+		int64_t sec = mlfqs_seconds - DECAY_HISTORY + 1;
+		fixed_t coeff = decay_coeff[sec % DECAY_HISTORY];
+		fixed_t coeff_pow = FP_CONST(1);
+		fixed_t base = coeff;
+		int64_t k;
+
+		/* coeff_pow = coeff ^ (missed - DECAY_HISTORY), by squaring. */
+		for (k = missed - DECAY_HISTORY; k > 0 && coeff_pow != 0; k >>= 1) {
+			if (k & 1)
+				coeff_pow = FP_MUL(coeff_pow, base);
+			base = FP_MUL(base, base);
+		}
+
+		fixed_t equilibrium =
+			FP_MUL_MIXED(FP_DIV(FP_CONST(1), FP_SUB(FP_CONST(1), coeff)), t->nice);
+		t->recent_cpu = FP_ADD(equilibrium, FP_MUL(coeff_pow, FP_SUB(t->recent_cpu, equilibrium)));
+		missed = DECAY_HISTORY;
+	}
 
-	t->recent_cpu = FP_ADD_MIXED(FP_MUL(coeff, t->recent_cpu), t->nice);
+	for (int64_t sec = mlfqs_seconds - missed + 1; sec <= mlfqs_seconds; sec++)
+		t->recent_cpu =
+			FP_ADD_MIXED(FP_MUL(decay_coeff[sec % DECAY_HISTORY], t->recent_cpu), t->nice);
+	t->recent_cpu_sec = mlfqs_seconds;
 }
 
 static void mlfqs_update_load_avg(void)
 {
 	/* load_avg = (59/60)*load_avg + (1/60)*ready_threads */
-	int ready_threads = list_size(&ready_list);
+	int ready_threads = ready_cnt;
 	if (thread_current() != idle_thread)
 		ready_threads++;
 
@@ -786,20 +1452,13 @@ static void mlfqs_update_load_avg(void)
 	fixed_t term2 = FP_MUL_MIXED(FP_DIV_MIXED(FP_CONST(1), 60), ready_threads);
 	load_avg = FP_ADD(term1, term2);
 }
-static void mlfqs_update_recent_cpu_all(void)
-{
-	struct list_elem *e;
-	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
-		struct thread *t = list_entry(e, struct thread, allelem);
-		mlfqs_update_recent_cpu(t);
-	}
-}
 
-static void mlfqs_update_priority_all(void)
+/* Starts a new second and records its recent_cpu decay
+   coefficient, computed from the just-updated load_avg. */
+static void mlfqs_record_decay(void)
 {
-	struct list_elem *e;
-	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
-		struct thread *t = list_entry(e, struct thread, allelem);
-		mlfqs_update_priority(t);
-	}
+	fixed_t coeff = FP_DIV(FP_MUL_MIXED(load_avg, 2), FP_ADD_MIXED(FP_MUL_MIXED(load_avg, 2), 1));
+
+	mlfqs_seconds++;
+	decay_coeff[mlfqs_seconds % DECAY_HISTORY] = coeff;
 }
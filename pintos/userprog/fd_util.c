@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "threads/interrupt.h"
+
 #define WORD_SIZE 64
 
 struct file *stdin_entry;
@@ -13,8 +15,16 @@ struct fd_table {
 	int next_fd;
 	unsigned long *bitmap;
 	struct file **file_list;
+	struct fd_table *next_free; /* Link in fd_cache. */
 };
 
+/* Empty fd_tables of exited processes, kept at their initial
+   size so that fd_init() can reuse them instead of making three
+   allocations per process.  Protected by disabling interrupts. */
+#define FD_CACHE_MAX 16
+static struct fd_table *fd_cache;
+static size_t fd_cache_cnt;
+
 static int fd_find_next(struct fd_table *fd_t);
 static bool fd_table_expand(struct fd_table *fd_t);
 
@@ -30,20 +40,28 @@ void init_std_fds()
 
 bool fd_init(struct thread *t)
 {
-	t->fd_table = malloc(sizeof(struct fd_table));
-	if (t->fd_table == NULL) {
-		free(t->fd_table);
-		return false;
+	enum intr_level old_level = intr_disable();
+	t->fd_table = fd_cache;
+	if (fd_cache != NULL) {
+		fd_cache = fd_cache->next_free;
+		fd_cache_cnt--;
 	}
+	intr_set_level(old_level);
 
-	t->fd_table->size = WORD_SIZE;
-	t->fd_table->file_list = calloc(t->fd_table->size, sizeof(struct file *));
-	t->fd_table->bitmap = calloc(1, sizeof(unsigned long));
+	if (t->fd_table == NULL) {
+		t->fd_table = malloc(sizeof(struct fd_table));
+		if (t->fd_table == NULL)
+			return false;
 
-	if (t->fd_table->file_list == NULL || t->fd_table->bitmap == NULL) {
-		free(t->fd_table->bitmap);
-		free(t->fd_table->file_list);
-		return false;
+		t->fd_table->size = WORD_SIZE;
+		t->fd_table->file_list = calloc(t->fd_table->size, sizeof(struct file *));
+		t->fd_table->bitmap = calloc(1, sizeof(unsigned long));
+
+		if (t->fd_table->file_list == NULL || t->fd_table->bitmap == NULL) {
+			free(t->fd_table->bitmap);
+			free(t->fd_table->file_list);
+			return false;
+		}
 	}
 
 	t->fd_table->next_fd = 2;
@@ -140,6 +158,22 @@ void fd_clean(struct thread *t)
 	for (int i = 2; i < t->fd_table->size; i++) {
 		fd_close(t->fd_table, i);
 	}
+
+	/* Keep tables that were never expanded for the next process. */
+	if (t->fd_table->size == WORD_SIZE) {
+		enum intr_level old_level = intr_disable();
+		if (fd_cache_cnt < FD_CACHE_MAX) {
+			memset(t->fd_table->file_list, 0, WORD_SIZE * sizeof(struct file *));
+			t->fd_table->bitmap[0] = 0;
+			t->fd_table->next_free = fd_cache;
+			fd_cache = t->fd_table;
+			fd_cache_cnt++;
+			t->fd_table = NULL;
+		}
+		intr_set_level(old_level);
+		if (t->fd_table == NULL)
+			return;
+	}
 	free(t->fd_table->bitmap);
 	free(t->fd_table->file_list);
 	free(t->fd_table);
@@ -0,0 +1,178 @@
+#include "userprog/futex.h"
+
+#include <futex.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/validate.h"
+
+/* Futex wait queues.
+
+   Waiters are kept in a fixed hash table keyed by the kernel
+   address of the word they wait on, that is, by the physical
+   frame behind the user address plus the offset in it, and
+   hashed by frame so that all the waiters on one frame share a
+   bucket.  Processes meet on a futex exactly when they share the
+   frame holding it, for example a page that fork() shared
+   copy-on-write and neither side has written since; two
+   processes that merely use the same virtual address never wake
+   each other.  Each waiter lives on the kernel stack of the
+   blocked thread and sleeps on its own semaphore, so no memory is
+   allocated on either path.
+
+   futex_lock serializes the check of the word in futex_wait()
+   against futex_wake(): a waker that changes the word and then
+   calls futex_wake() either runs before the check, in which case
+   the waiter sees the new value and returns, or after the waiter
+   is queued, in which case it is woken.  The check reads the
+   frame through its kernel address, so nothing faults with
+   futex_lock held.
+
+   A frame that is evicted no longer holds the word when it is
+   next faulted in, so futex_wake_page() wakes everything queued
+   on it and the waiters return as if woken spuriously, which
+   callers must tolerate anyway. */
+
+#define FUTEX_BUCKETS 64
+
+/* A thread blocked in futex_wait(). */
+struct futex_waiter {
+	struct list_elem elem;	 /* Element in a futex_table bucket. */
+	const int *key;			 /* Kernel address of the word waited on. */
+	struct semaphore wakeup; /* Upped by futex_wake(). */
+};
+
+static struct list futex_table[FUTEX_BUCKETS];
+static struct lock futex_lock;
+
+static struct list *futex_bucket(const void *key);
+static bool futex_valid(const int *uaddr);
+
+/* Initializes the futex wait queues. */
+void futex_init(void)
+{
+	for (size_t i = 0; i < FUTEX_BUCKETS; i++)
+		list_init(&futex_table[i]);
+	lock_init(&futex_lock);
+}
+
+/* Blocks the current thread on UADDR as long as *UADDR == VAL.
+   Returns 0 after being woken, or -1 without blocking if UADDR
+   is misaligned or no longer holds VAL.  An unmapped UADDR
+   terminates the process. */
+int futex_wait(int *uaddr, int val)
+{
+	uint64_t *pml4 = thread_current()->pml4;
+	struct futex_waiter w;
+	int cur;
+
+	if (!futex_valid(uaddr))
+		return -1;
+
+	/* Fault the word in before taking futex_lock, since a bad
+	   address kills the process and would leave the lock held.
+	   It can be evicted again before the lookup, so retry until
+	   it is resident with the lock held. */
+	for (;;) {
+		copy_user_buffer((char *)&cur, (const char *)uaddr, sizeof cur);
+		lock_acquire(&futex_lock);
+		w.key = pml4_get_page(pml4, uaddr);
+		if (w.key != NULL)
+			break;
+		lock_release(&futex_lock);
+	}
+
+	if (*w.key != val) {
+		lock_release(&futex_lock);
+		return -1;
+	}
+
+	sema_init(&w.wakeup, 0);
+	list_push_back(futex_bucket(w.key), &w.elem);
+	lock_release(&futex_lock);
+
+	sema_down(&w.wakeup);
+	return 0;
+}
+
+/* Wakes up to CNT threads blocked on the word at UADDR in any
+   process that shares the frame holding it, oldest first.
+   Returns the number woken, or -1 if UADDR is misaligned. */
+int futex_wake(int *uaddr, int cnt)
+{
+	struct list *bucket;
+	struct list_elem *e;
+	const int *key;
+	int woken = 0;
+
+	if (!futex_valid(uaddr))
+		return -1;
+
+	lock_acquire(&futex_lock);
+	/* Nobody can be waiting on a word that is not resident here:
+	   a waiter shares the frame, and eviction unmaps every
+	   sharer at once. */
+	key = pml4_get_page(thread_current()->pml4, uaddr);
+	if (key == NULL) {
+		lock_release(&futex_lock);
+		return 0;
+	}
+	bucket = futex_bucket(key);
+	for (e = list_begin(bucket); e != list_end(bucket) && woken < cnt;) {
+		struct futex_waiter *w = list_entry(e, struct futex_waiter, elem);
+
+		if (w->key != key) {
+			e = list_next(e);
+			continue;
+		}
+		e = list_remove(e);
+		sema_up(&w->wakeup);
+		woken++;
+	}
+	lock_release(&futex_lock);
+	return woken;
+}
+
+/* Wakes every thread blocked on a word in the frame at KPAGE,
+   which is about to be reused for another page.  The frame must
+   already be unmapped, so that no new waiter can queue on it. */
+void futex_wake_page(void *kpage)
+{
+	struct list *bucket = futex_bucket(kpage);
+	struct list_elem *e;
+
+	ASSERT(pg_ofs(kpage) == 0);
+
+	lock_acquire(&futex_lock);
+	for (e = list_begin(bucket); e != list_end(bucket);) {
+		struct futex_waiter *w = list_entry(e, struct futex_waiter, elem);
+
+		if (pg_round_down(w->key) != kpage) {
+			e = list_next(e);
+			continue;
+		}
+		e = list_remove(e);
+		sema_up(&w->wakeup);
+	}
+	lock_release(&futex_lock);
+}
+
+/* Returns the wait queue for the word at kernel address KEY. */
+static struct list *futex_bucket(const void *key)
+{
+	uint64_t page = (uint64_t)pg_round_down(key);
+
+	return &futex_table[hash_bytes(&page, sizeof page) % FUTEX_BUCKETS];
+}
+
+/* Returns true if UADDR can name a futex: a non-null, int-aligned
+   user address. */
+static bool futex_valid(const int *uaddr)
+{
+	return uaddr != NULL && is_user_vaddr(uaddr) && (uintptr_t)uaddr % sizeof(int) == 0;
+}
@@ -255,24 +255,15 @@ int process_exec(void *f_name)
  * does nothing. */
 int process_wait(tid_t child_tid)
 {
-	struct thread *cur = thread_current();
-	struct child_info *child_info = NULL;
-
-	struct list_elem *e = list_begin(&cur->child_list);
-	for (; e != list_end(&cur->child_list); e = list_next(e)) {
-		child_info = list_entry(e, struct child_info, child_elem);
-		if (child_info->tid == child_tid)
-			break;
-	}
+	struct child_info *child_info = thread_find_child(child_tid);
 
-	if (e == list_end(&cur->child_list) || child_info->wait)
+	if (child_info == NULL || child_info->wait)
 		return -1;
 	child_info->wait = true;
 	sema_down(&child_info->wait_sema);
 
 	int result = child_info->exit_status;
-	list_remove(&child_info->child_elem);
-	free(child_info);
+	thread_reap_child(child_info);
 	return result;
 }
 
@@ -296,9 +287,7 @@ static void process_cleanup(void)
 
 	if (curr->current_file) {
 		file_allow_write(curr->current_file);
-		lock_acquire(&file_lock);
 		file_close(curr->current_file);
-		lock_release(&file_lock);
 		curr->current_file = NULL;
 	}
 
@@ -415,9 +404,7 @@ static bool load(const char *file_name, int argc, char **argv, struct intr_frame
 	supplemental_page_table_init(&thread_current()->spt);
 
 	/* Open executable file. */
-	lock_acquire(&file_lock);
 	file = filesys_open(file_name);
-	lock_release(&file_lock);
 	if (file == NULL) {
 		printf("load: %s: open failed\n", file_name);
 		goto done;
@@ -686,16 +673,13 @@ static bool lazy_load_segment(struct page *page, void *aux)
 	off_t ofs = vm_load_aux->offset;
 	size_t page_read_bytes = vm_load_aux->page_read_bytes;
 
-	lock_acquire(&file_lock);
 	int read_result = file_read_at(file, page->frame->kva, page_read_bytes, ofs);
-	lock_release(&file_lock);
-	if (read_result != (int)page_read_bytes) {
-		palloc_free_page(page->frame->kva);
+	/* On failure vm_do_claim_page() frees the frame. */
+	if (read_result != (int)page_read_bytes)
 		return false;
-	}
 
 	memset(page->frame->kva + page_read_bytes, 0, PGSIZE - page_read_bytes);
-	free(aux);
+	vm_load_aux_free(aux);
 
 	return true;
 }
@@ -711,17 +695,23 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-		struct vm_load_aux *file_page_aux = malloc(sizeof(*file_page_aux));
-		*file_page_aux = (struct vm_load_aux){
-			.offset = ofs,
-			.page_read_bytes = page_read_bytes,
-		};
-		
-		// 파일은 mmap, stack은 anon, 실행파일도 anon!!! write back 기준으로!
-		if (!vm_alloc_page_with_initializer(VM_ANON | VM_LOAD_MARKER, upage, writable, lazy_load_segment,
-											file_page_aux))
-			return false;
-			
+		// 읽을 내용이 없는 bss 페이지는 파일을 건드리지 않는 zero-fill 페이지로 등록한다
+		if (page_read_bytes == 0) {
+			if (!vm_alloc_page(VM_ANON, upage, writable))
+				return false;
+		} else {
+			struct vm_load_aux *file_page_aux = vm_load_aux_alloc();
+			*file_page_aux = (struct vm_load_aux){
+				.offset = ofs,
+				.page_read_bytes = page_read_bytes,
+			};
+
+			// 파일은 mmap, stack은 anon, 실행파일도 anon!!! write back 기준으로!
+			if (!vm_alloc_page_with_initializer(VM_ANON | VM_LOAD_MARKER, upage, writable,
+												lazy_load_segment, file_page_aux))
+				return false;
+		}
+
 		/* Advance. */
 		read_bytes -= page_read_bytes;
 		zero_bytes -= page_zero_bytes;
@@ -1,5 +1,6 @@
 #include "userprog/syscall.h"
 
+#include <futex.h>
 #include <stdio.h>
 #include <syscall-nr.h>
 
@@ -14,6 +15,7 @@
 #include "threads/thread.h"
 #include "user/syscall.h"
 #include "userprog/fd_util.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
 #include "userprog/process.h"
 #include "userprog/validate.h"
@@ -36,8 +38,6 @@ void syscall_handler(struct intr_frame *);
 
 #define MAX_FILE_NAME_LEN 16
 
-struct lock file_lock;
-
 static void syscall_halt(void);
 static void syscall_exit(int status);
 static pid_t syscall_fork(const char *thread_name, struct intr_frame *if_);
@@ -55,6 +55,9 @@ static void syscall_close(int fd);
 static int syscall_dup2(int oldfd, int newfd);
 static void *syscall_mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 static void syscall_munmap(void *addr);
+static bool syscall_sched_stats(int scope, struct sched_stats *stats);
+static bool syscall_set_deadline(int64_t period, int64_t budget);
+static int syscall_futex(int *uaddr, int op, int val);
 
 void syscall_init(void)
 {
@@ -65,7 +68,8 @@ void syscall_init(void)
 	 * until the syscall_entry swaps the userland stack to the kernel
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK, FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-	lock_init(&file_lock);
+
+	futex_init();
 }
 
 /* The main system call interface */
@@ -131,6 +135,15 @@ void syscall_handler(struct intr_frame *f)
 		case SYS_MUNMAP:
 			syscall_munmap(arg1);
 			break;
+		case SYS_SCHED_STATS:
+			f->R.rax = syscall_sched_stats(arg1, (struct sched_stats *)arg2);
+			break;
+		case SYS_SET_DEADLINE:
+			f->R.rax = syscall_set_deadline(arg1, arg2);
+			break;
+		case SYS_FUTEX:
+			f->R.rax = syscall_futex((int *)arg1, arg2, arg3);
+			break;
 	}
 }
 
@@ -177,11 +190,7 @@ static bool syscall_create(const char *file, unsigned initial_size)
 	if (!copy_user_string(kernel_file_name, file, MAX_FILE_NAME_LEN))
 		return false;
 
-	lock_acquire(&file_lock);
-	bool success = filesys_create(kernel_file_name, initial_size);
-	lock_release(&file_lock);
-
-	return success;
+	return filesys_create(kernel_file_name, initial_size);
 }
 
 static bool syscall_remove(const char *file)
@@ -191,11 +200,7 @@ static bool syscall_remove(const char *file)
 	if (!copy_user_string(kernel_file_name, file, MAX_FILE_NAME_LEN))
 		return false;
 
-	lock_acquire(&file_lock);
-	bool success = filesys_remove(kernel_file_name);
-	lock_release(&file_lock);
-
-	return success;
+	return filesys_remove(kernel_file_name);
 }
 
 static int syscall_open(const char *file)
@@ -205,10 +210,7 @@ static int syscall_open(const char *file)
 	if (!copy_user_string(kernel_file_name, file, MAX_FILE_NAME_LEN))
 		return -1;
 
-	lock_acquire(&file_lock);
 	struct file *open_file = filesys_open(kernel_file_name);
-	lock_release(&file_lock);
-
 	if (open_file == NULL)
 		return -1;
 
@@ -226,9 +228,7 @@ static int syscall_filesize(int fd)
 	if (file == NULL || file == stdin_entry || file == stdout_entry)
 		return -1;
 
-	lock_acquire(&file_lock);
 	result = file_length(file);
-	lock_release(&file_lock);
 
 	return result;
 }
@@ -247,7 +247,6 @@ static int syscall_read(int fd, void *buffer, unsigned size)
 		return -1;
 	}
 
-	lock_acquire(&file_lock);
 	if (file == stdin_entry) {
 		for (int i = 0; i < size; i++)
 			kernel_buffer[i] = input_getc();
@@ -255,7 +254,6 @@ static int syscall_read(int fd, void *buffer, unsigned size)
 	} else {
 		result = file_read(file, kernel_buffer, size);
 	}
-	lock_release(&file_lock);
 
 	if (!buffer_copy_to_user(buffer, kernel_buffer, result))
 		syscall_exit(-1);
@@ -283,14 +281,12 @@ static int syscall_write(int fd, const void *buffer, unsigned size)
 		return -1;
 	}
 
-	lock_acquire(&file_lock);
 	if (file == stdout_entry) {
 		putbuf(kernel_buffer, size);
 		result = size;
 	} else {
 		result = file_write(file, kernel_buffer, size);
 	}
-	lock_release(&file_lock);
 
 	free(kernel_buffer);
 	return result;
@@ -303,9 +299,7 @@ static void syscall_seek(int fd, unsigned position)
 	if (file == NULL)
 		return;
 
-	lock_acquire(&file_lock);
 	file_seek(file, position);
-	lock_release(&file_lock);
 }
 
 static unsigned syscall_tell(int fd)
@@ -314,25 +308,17 @@ static unsigned syscall_tell(int fd)
 	if (!file)
 		return 0;
 
-	lock_acquire(&file_lock);
-	unsigned result = file_tell(file);
-	lock_release(&file_lock);
-	return result;
+	return file_tell(file);
 }
 
 static void syscall_close(int fd)
 {
-	lock_acquire(&file_lock);
 	fd_close(thread_current()->fd_table, fd);
-	lock_release(&file_lock);
 }
 
 static int syscall_dup2(int oldfd, int newfd)
 {
-	lock_acquire(&file_lock);
-	int result = fd_dup2(thread_current()->fd_table, oldfd, newfd);
-	lock_release(&file_lock);
-	return result;
+	return fd_dup2(thread_current()->fd_table, oldfd, newfd);
 }
 
 static void *syscall_mmap(void *addr, size_t length, int writable, int fd, off_t offset)
@@ -369,4 +355,31 @@ static void syscall_munmap(void *addr)
 		return;
 
 	return do_munmap(addr);
-}
\ No newline at end of file
+}
+
+static bool syscall_sched_stats(int scope, struct sched_stats *stats)
+{
+	struct sched_stats kernel_stats;
+
+	if (!thread_get_sched_stats(scope, &kernel_stats))
+		return false;
+
+	return buffer_copy_to_user((char *)stats, (const char *)&kernel_stats, sizeof kernel_stats);
+}
+
+static bool syscall_set_deadline(int64_t period, int64_t budget)
+{
+	return thread_set_deadline(period, budget);
+}
+
+static int syscall_futex(int *uaddr, int op, int val)
+{
+	switch (op) {
+		case FUTEX_WAIT:
+			return futex_wait(uaddr, val);
+		case FUTEX_WAKE:
+			return futex_wake(uaddr, val);
+		default:
+			return -1;
+	}
+}
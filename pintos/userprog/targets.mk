@@ -5,4 +5,5 @@ userprog_SRC += userprog/syscall.c	# System call handler.
 userprog_SRC += userprog/gdt.c		# GDT initialization.
 userprog_SRC += userprog/tss.c		# TSS management.
 userprog_SRC += userprog/fd_util.c	# File descriptor table.
+userprog_SRC += userprog/futex.c	# Futex wait queues.
 userprog_SRC += userprog/validate.c
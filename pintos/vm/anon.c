@@ -2,7 +2,9 @@
 
 #include "vm/vm.h"
 #include "devices/disk.h"
+#include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "vm/zswap.h"
 #include <bitmap.h>
 
 /* DO NOT MODIFY BELOW LINE */
@@ -11,7 +13,32 @@ static bool anon_swap_in(struct page *page, void *kva);
 static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
 
+static size_t swap_slot_alloc(void);
+static void swap_slot_free(size_t slot);
+
+/* Swap slots.  Each slot holds one page in SECTORS_PER_SLOT
+ * consecutive sectors of the swap disk.  A set bit in swap_table
+ * marks a slot in use.
+ *
+ * Slots are handed out from clusters of SWAP_CLUSTER free slots
+ * in a row, found next-fit from a cursor that only moves forward
+ * and wraps around at the end of the disk.  Pages evicted one
+ * after another thus land next to each other on disk, and the
+ * bitmap is searched once per cluster rather than from slot 0
+ * for every page.
+ *
+ * swap_lock protects swap_table and the cursor.  Slots are
+ * allocated on the eviction path, under the frame table lock and
+ * possibly zswap_lock, but freed on swap-in and when a page is
+ * destroyed, under neither, so the bitmap needs a lock of its
+ * own.  It is taken last and never held across disk I/O. */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+#define SWAP_CLUSTER 16
+
 static struct bitmap *swap_table;
+static struct lock swap_lock;
+static size_t swap_cursor;	/* Next slot to hand out. */
+static size_t cluster_left; /* Slots left in the cluster at swap_cursor. */
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
@@ -25,12 +52,14 @@ static const struct page_operations anon_ops = {
 void vm_anon_init(void)
 {
 	swap_disk = disk_get(1, 1);
-	swap_table = bitmap_create(disk_size(swap_disk) / (PGSIZE / DISK_SECTOR_SIZE));
+	swap_table = bitmap_create(disk_size(swap_disk) / SECTORS_PER_SLOT);
 	if (swap_table == NULL)
 		// PANIC("vm_anon_init: cannot create swap bitmap");
 		printf("vm_anon_init: cannot create swap bitmap");
 
 	bitmap_set_all(swap_table, false);
+	lock_init(&swap_lock);
+	zswap_init();
 }
 
 /* Initialize the file mapping */
@@ -41,29 +70,33 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva)
 
 	struct anon_page *anon_page = &page->anon;
 	anon_page->swap_table_index = BITMAP_ERROR;
+	anon_page->zswap = NULL;
 	return true;
 }
 
-/* Swap in the page by read contents from the swap disk. */
+/* Swap in the page by read contents from the zswap cache or the
+ * swap disk. */
 static bool anon_swap_in(struct page *page, void *kva)
 {
 	struct anon_page *anon_page = &page->anon;
+
+	if (zswap_load(page, kva))
+		return true;
+
 	size_t bitmap_index = anon_page->swap_table_index;
 
 	if (bitmap_index == BITMAP_ERROR)
 		return false;
 
-	disk_sector_t start_disk_sec = bitmap_index * 8;
-	for (int i = 0; i < (PGSIZE / DISK_SECTOR_SIZE); i++) {
-		disk_read(swap_disk, (start_disk_sec + i), kva + (DISK_SECTOR_SIZE * i));
-	}
+	disk_read_sectors(swap_disk, bitmap_index * SECTORS_PER_SLOT, kva, SECTORS_PER_SLOT);
 
-	bitmap_set(swap_table, bitmap_index, false);
+	swap_slot_free(bitmap_index);
 	anon_page->swap_table_index = BITMAP_ERROR;
 	return true;
 }
 
-/* Swap out the page by writing contents to the swap disk. */
+/* Swap out the page by compressing it into the zswap cache or,
+ * failing that, writing contents to the swap disk. */
 static bool anon_swap_out(struct page *page)
 {
 	struct anon_page *anon_page = &page->anon;
@@ -71,14 +104,22 @@ static bool anon_swap_out(struct page *page)
 	if (anon_page->swap_table_index != BITMAP_ERROR)
 		return false;
 
-	size_t bitmap_index = bitmap_scan_and_flip(swap_table, 0, 1, false);
+	if (zswap_store(page, page->frame->kva))
+		return true;
+	return anon_swap_write(page, page->frame->kva);
+}
+
+/* Writes the contents of PAGE, at KVA, to a new swap slot.
+ * Returns false if swap is full. */
+bool anon_swap_write(struct page *page, const void *kva)
+{
+	struct anon_page *anon_page = &page->anon;
+
+	size_t bitmap_index = swap_slot_alloc();
 	if (bitmap_index == BITMAP_ERROR)
 		return false;
 
-	disk_sector_t start_disk_sec = bitmap_index * 8;
-	for (int i = 0; i < (PGSIZE / DISK_SECTOR_SIZE); i++) {
-		disk_write(swap_disk, (start_disk_sec + i), page->frame->kva + (DISK_SECTOR_SIZE * i));
-	}
+	disk_write_sectors(swap_disk, bitmap_index * SECTORS_PER_SLOT, kva, SECTORS_PER_SLOT);
 
 	anon_page->swap_table_index = bitmap_index;
 	return true;
@@ -89,21 +130,65 @@ static void anon_destroy(struct page *page)
 {
 	struct anon_page *anon_page = &page->anon;
 
-	// swap disk 있으면 해제
-	if (anon_page->swap_table_index != BITMAP_ERROR) {
-		bitmap_set(swap_table, anon_page->swap_table_index, false);
+	// pte에서 매핑 제거
+	if (page->frame != NULL)
+		pml4_clear_page(thread_current()->pml4, page->va);
+
+	// 물리메모리와 frame 구조체 해제 (공유 중이면 참조만 놓는다)
+	// 진행 중인 eviction이 이 페이지를 zswap에 넣을 수 있으므로,
+	// frame table lock으로 그 eviction이 끝나길 기다린 뒤에 캐시를 확인한다
+	vm_release_frame(page);
+
+	// zswap 캐시나 swap disk에 있으면 해제
+	// (캐시에서 먼저 빼야 spill이 설정한 swap slot까지 확인할 수 있다)
+	size_t slot = zswap_invalidate(page);
+	if (slot != BITMAP_ERROR) {
+		swap_slot_free(slot);
 		anon_page->swap_table_index = BITMAP_ERROR;
 	}
+}
 
-	if (page->frame != NULL) {
-		// pte에서 매핑 제거
-		pml4_clear_page(thread_current()->pml4, page->va);
+/* Marks a free swap slot in use and returns its index, or
+ * BITMAP_ERROR if swap is full. */
+static size_t swap_slot_alloc(void)
+{
+	size_t slot;
+
+	lock_acquire(&swap_lock);
+	if (cluster_left == 0) {
+		/* Start a new cluster, preferring a full run of free slots. */
+		size_t cnt = SWAP_CLUSTER;
+
+		slot = bitmap_scan(swap_table, swap_cursor, cnt, false);
+		if (slot == BITMAP_ERROR)
+			slot = bitmap_scan(swap_table, 0, cnt, false);
+		if (slot == BITMAP_ERROR) {
+			cnt = 1;
+			slot = bitmap_scan(swap_table, swap_cursor, cnt, false);
+			if (slot == BITMAP_ERROR)
+				slot = bitmap_scan(swap_table, 0, cnt, false);
+			if (slot == BITMAP_ERROR) {
+				lock_release(&swap_lock);
+				return BITMAP_ERROR;
+			}
+		}
+		swap_cursor = slot;
+		cluster_left = cnt;
+	}
 
-		// 물리메모리도 제거
-		palloc_free_page(page->frame->kva);
+	slot = swap_cursor++;
+	cluster_left--;
+	ASSERT(!bitmap_test(swap_table, slot));
+	bitmap_mark(swap_table, slot);
+	lock_release(&swap_lock);
+	return slot;
+}
 
-		// frame 구조체 해제
-		free(page->frame);
-		page->frame = NULL;
-	}
+/* Marks SLOT, which must be in use, free again. */
+static void swap_slot_free(size_t slot)
+{
+	lock_acquire(&swap_lock);
+	ASSERT(bitmap_test(swap_table, slot));
+	bitmap_reset(swap_table, slot);
+	lock_release(&swap_lock);
 }
@@ -1,6 +1,7 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include "threads/slab.h"
 #include "threads/vaddr.h"
 #include "userprog/syscall.h"
 
@@ -9,6 +10,8 @@ static bool file_backed_swap_out(struct page *page);
 static void file_backed_destroy(struct page *page);
 static bool lazy_load_file(struct page *page, void *aux);
 
+static struct kmem_cache mmap_aux_cache;
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
 	.swap_in = file_backed_swap_in,
@@ -20,6 +23,19 @@ static const struct page_operations file_ops = {
 /* The initializer of file vm */
 void vm_file_init(void)
 {
+	kmem_cache_init(&mmap_aux_cache, "mmap_aux", sizeof(struct mmap_aux), 0, NULL);
+}
+
+/* Allocates the aux of a lazily loaded mmap page. */
+struct mmap_aux *mmap_aux_alloc(void)
+{
+	return kmem_cache_alloc(&mmap_aux_cache);
+}
+
+/* Frees AUX, which must come from mmap_aux_alloc(). */
+void mmap_aux_free(struct mmap_aux *aux)
+{
+	kmem_cache_free(&mmap_aux_cache, aux);
 }
 
 /* Initialize the file backed page */
@@ -60,9 +76,7 @@ static bool file_backed_swap_in(struct page *page, void *kva)
 	off_t ofs = file_page->offset;
 	size_t page_read_bytes = file_page->page_read_bytes;
 
-	lock_acquire(&file_lock);
 	int result = file_read_at(file, page->frame->kva, page_read_bytes, ofs);
-	lock_release(&file_lock);
 
 	if (result != file_page->page_read_bytes) {
 		// 파일 쓰기에 실패했다면 OS가 할 수 있는 일은 없다.
@@ -81,15 +95,14 @@ static bool file_backed_swap_out(struct page *page)
 		return false;
 
 	struct file_page *file_page = &page->file;
-	bool is_dirty = pml4_is_dirty(thread_current()->pml4, page->va);
+	uint64_t *pml4 = page->owner_thread->pml4;
+	bool is_dirty = pml4_is_dirty(pml4, page->va);
 	if (is_dirty) {
 		struct file *file = file_page->file;
 		off_t ofs = file_page->offset;
 		size_t page_read_bytes = file_page->page_read_bytes;
 
-		lock_acquire(&file_lock);
 		off_t result = file_write_at(file, page->frame->kva, page_read_bytes, ofs);
-		lock_release(&file_lock);
 
 		if (result != file_page->page_read_bytes) {
 			// 파일 쓰기에 실패했다면 OS가 할 수 있는 일은 없다.
@@ -98,7 +111,7 @@ static bool file_backed_swap_out(struct page *page)
 		}
 	}
 
-	pml4_set_dirty(thread_current()->pml4, page->va, false);
+	pml4_set_dirty(pml4, page->va, false);
 	return true;
 }
 
@@ -114,10 +127,8 @@ static void file_backed_destroy(struct page *page)
 	// pte에서 매핑 제거
 	pml4_clear_page(thread_current()->pml4, page->va);
 
-	// 물리메모리도 해제
-	palloc_free_page(page->frame->kva);
-	free(page->frame);
-	page->frame = NULL;
+	// 물리메모리와 frame 구조체도 해제
+	vm_release_frame(page);
 }
 
 /*
@@ -141,7 +152,7 @@ void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t
 	while (read_bytes > 0) {
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 
-		struct mmap_aux *mmap_aux = malloc(sizeof(*mmap_aux));
+		struct mmap_aux *mmap_aux = mmap_aux_alloc();
 		if (!mmap_aux)
 			return NULL;
 
@@ -155,7 +166,7 @@ void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t
 
 		if (!vm_alloc_page_with_initializer(VM_FILE, addr_copy, writable, lazy_load_file,
 											mmap_aux)) {
-			free(mmap_aux);
+			mmap_aux_free(mmap_aux);
 			mmap_aux = NULL;
 			goto error;
 		}
@@ -182,13 +193,11 @@ static bool lazy_load_file(struct page *page, void *aux)
 	off_t ofs = mmap_aux->offset;
 	size_t page_read_bytes = mmap_aux->page_read_bytes;
 
-	lock_acquire(&file_lock);
 	int read_result = file_read_at(file, page->frame->kva, page_read_bytes, ofs);
-	lock_release(&file_lock);
 
 	page->file.page_read_bytes = read_result;
 	memset(page->frame->kva + read_result, 0, PGSIZE - read_result);
-	free(aux);
+	mmap_aux_free(aux);
 
 	return true;
 }
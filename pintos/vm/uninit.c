@@ -10,10 +10,13 @@
 
 #include "vm/vm.h"
 #include "vm/uninit.h"
+#include "threads/slab.h"
 
 static bool uninit_initialize(struct page *page, void *kva);
 static void uninit_destroy(struct page *page);
 
+static struct kmem_cache vm_load_aux_cache;
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations uninit_ops = {
 	.swap_in = uninit_initialize,
@@ -22,6 +25,24 @@ static const struct page_operations uninit_ops = {
 	.type = VM_UNINIT,
 };
 
+/* Initializes the cache of executable segment aux. */
+void vm_uninit_init(void)
+{
+	kmem_cache_init(&vm_load_aux_cache, "vm_load_aux", sizeof(struct vm_load_aux), 0, NULL);
+}
+
+/* Allocates the aux of a lazily loaded executable page. */
+struct vm_load_aux *vm_load_aux_alloc(void)
+{
+	return kmem_cache_alloc(&vm_load_aux_cache);
+}
+
+/* Frees AUX, which must come from vm_load_aux_alloc(). */
+void vm_load_aux_free(struct vm_load_aux *aux)
+{
+	kmem_cache_free(&vm_load_aux_cache, aux);
+}
+
 /* DO NOT MODIFY this function */
 void uninit_new(struct page *page, void *va, vm_initializer *init, enum vm_type type, void *aux,
 				bool (*initializer)(struct page *, enum vm_type, void *))
@@ -60,6 +81,12 @@ static void uninit_destroy(struct page *page)
 {
 	struct uninit_page *uninit UNUSED = &page->uninit;
 
-	free(uninit->aux);
+	/* The aux of an executable or mmap page is ours to free.  Any
+	 * other aux, such as the one fork() passes along with a page
+	 * it claims at once, is borrowed. */
+	if (uninit->type & VM_LOAD_MARKER)
+		vm_load_aux_free(uninit->aux);
+	else if (VM_TYPE(uninit->type) == VM_FILE && uninit->init != NULL)
+		mmap_aux_free(uninit->aux);
 	uninit->aux = NULL;
 }
@@ -1,10 +1,13 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
 #include "vm/vm.h"
-#include "threads/malloc.h"
 #include "threads/mmu.h"
+#include "threads/slab.h"
 #include "threads/vaddr.h"
+#include "userprog/futex.h"
 #include "vm/inspect.h"
+#include "vm/zswap.h"
+#include <stdio.h>
 #include <string.h>
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
@@ -13,6 +16,27 @@
 static struct list frame_list;
 static struct lock frame_table_lock;
 
+/* Clock hand: the frame in frame_list that eviction examines
+ * next, or the list tail to start over from the front. */
+static struct list_elem *clock_hand;
+
+/* Statistics. */
+static long long fault_cnt;		  /* # of faults handled by vm_try_handle_fault(). */
+static long long evict_cnt;		  /* # of frames evicted. */
+static long long evict_clean_cnt; /* # of those that needed no writeback. */
+
+/* Caches of page and frame structures, which every fault
+ * allocates. */
+static struct kmem_cache page_kcache;
+static struct kmem_cache frame_kcache;
+
+/* The zero page: one frame of zeros that every anonymous page
+ * that is read before it is ever written maps read-only, until a
+ * write gives the page a private frame through vm_handle_wp().
+ * It holds a reference of its own, so it is never freed, and it
+ * is not in frame_list, so it is never evicted. */
+static struct frame zero_frame;
+
 void vm_init(void)
 {
 	vm_anon_init();
@@ -24,6 +48,14 @@ void vm_init(void)
 	/* DO NOT MODIFY UPPER LINES. */
 	list_init(&frame_list);
 	lock_init(&frame_table_lock);
+	clock_hand = list_end(&frame_list);
+	kmem_cache_init(&page_kcache, "page", sizeof(struct page), CACHE_LINE_SIZE, NULL);
+	kmem_cache_init(&frame_kcache, "frame", sizeof(struct frame), 0, NULL);
+	vm_uninit_init();
+
+	zero_frame.kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+	zero_frame.ref_cnt = 1;
+	list_init(&zero_frame.pages);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -42,6 +74,15 @@ enum vm_type page_get_type(struct page *page)
 
 /* Helpers */
 static struct frame *vm_get_victim(void);
+static struct frame *clock_advance(void);
+static bool frame_test_accessed(struct frame *frame);
+static bool frame_is_clean(struct frame *frame);
+static void frame_list_remove(struct frame *frame);
+static void frame_free(struct frame *frame);
+static bool vm_share_frame(struct page *dst, struct page *src);
+static bool vm_fault_in(struct page *page, bool write);
+static bool page_is_zero_fill(struct page *page);
+static bool vm_map_zero_page(struct page *page);
 static bool vm_do_claim_page(struct page *page);
 static struct frame *vm_evict_frame(void);
 
@@ -62,7 +103,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		return false;
 
 	// 2. struct page
-	struct page *page = malloc(sizeof(struct page));
+	struct page *page = kmem_cache_alloc(&page_kcache);
 	if (page == NULL)
 		return false;
 
@@ -90,7 +131,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 	return true;
 
 err:
-	free(page);
+	kmem_cache_free(&page_kcache, page);
 	return false;
 }
 
@@ -130,27 +171,133 @@ void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 	vm_dealloc_page(page);
 }
 
-/* Get the struct frame, that will be evicted. */
+/* Get the struct frame, that will be evicted.
+ *
+ * This is the clock (second chance) algorithm.  The hand sweeps
+ * frame_list, clearing the accessed bits of each frame it passes,
+ * and stops at the first frame that has not been accessed since
+ * the last sweep and can be dropped without writeback.  Failing
+ * that, the first unaccessed frame that needs writeback is taken.
+ * After one full turn every accessed bit has been cleared, so two
+ * turns always find a victim.  The victim is removed from
+ * frame_list.  Must be called with frame_table_lock held. */
 static struct frame *vm_get_victim(void)
 {
-	struct frame *victim = list_entry(list_pop_front(&frame_list), struct frame, frame_elem);
+	struct frame *victim = NULL;
+	size_t turn = 2 * list_size(&frame_list);
+
+	ASSERT(lock_held_by_current_thread(&frame_table_lock));
+	ASSERT(!list_empty(&frame_list));
+
+	while (turn-- > 0) {
+		struct frame *frame = clock_advance();
+
+		if (frame_test_accessed(frame))
+			continue;
+		if (frame_is_clean(frame)) {
+			victim = frame;
+			break;
+		}
+		if (victim == NULL)
+			victim = frame;
+	}
+	if (victim == NULL)
+		victim = clock_advance();
+
+	frame_list_remove(victim);
 	return victim;
 }
 
+/* Returns the frame under the clock hand and moves the hand to
+ * the next one, wrapping around at the end of frame_list. */
+static struct frame *clock_advance(void)
+{
+	if (clock_hand == list_end(&frame_list))
+		clock_hand = list_begin(&frame_list);
+	ASSERT(clock_hand != list_end(&frame_list));
+
+	struct frame *frame = list_entry(clock_hand, struct frame, frame_elem);
+	clock_hand = list_next(clock_hand);
+	return frame;
+}
+
+/* Returns true if any page mapping FRAME has been accessed since
+ * the last call, and clears the accessed bits. */
+static bool frame_test_accessed(struct frame *frame)
+{
+	bool accessed = false;
+
+	for (struct list_elem *e = list_begin(&frame->pages); e != list_end(&frame->pages);
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, mapping_elem);
+		uint64_t *pml4 = page->owner_thread->pml4;
+
+		if (pml4_is_accessed(pml4, page->va)) {
+			pml4_set_accessed(pml4, page->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Returns true if FRAME can be evicted without writing it
+ * anywhere: a file-backed page that has not been written since it
+ * was read.  Anonymous pages always go to swap.  Only anonymous
+ * frames are ever shared. */
+static bool frame_is_clean(struct frame *frame)
+{
+	struct page *page = list_entry(list_front(&frame->pages), struct page, mapping_elem);
+
+	return VM_TYPE(page->operations->type) == VM_FILE &&
+		   !pml4_is_dirty(page->owner_thread->pml4, page->va);
+}
+
+/* Removes FRAME from frame_list, keeping the clock hand on a
+ * frame that is still in the list.  Must be called with
+ * frame_table_lock held. */
+static void frame_list_remove(struct frame *frame)
+{
+	if (clock_hand == &frame->frame_elem)
+		clock_hand = list_next(clock_hand);
+	list_remove(&frame->frame_elem);
+}
+
+/* Frees FRAME, which no page maps any more, and its physical
+ * page. */
+static void frame_free(struct frame *frame)
+{
+	ASSERT(frame->ref_cnt == 0);
+
+	palloc_free_page(frame->kva);
+	kmem_cache_free(&frame_kcache, frame);
+}
+
 /* Evict one page and return the corresponding frame.
+ * A shared frame is swapped out once for each page mapping it.
  * Return NULL on error.*/
 static struct frame *vm_evict_frame(void)
 {
 	lock_acquire(&frame_table_lock);
 	struct frame *victim = vm_get_victim();
-	struct page *page = victim->page;
 
-	swap_out(page);
+	evict_cnt++;
+	if (frame_is_clean(victim))
+		evict_clean_cnt++;
+
+	while (!list_empty(&victim->pages)) {
+		struct page *page = list_entry(list_front(&victim->pages), struct page, mapping_elem);
 
-	pml4_clear_page(page->owner_thread->pml4, page->va);
-	page->frame = NULL;
-	victim->page = NULL;
+		swap_out(page);
+		pml4_clear_page(page->owner_thread->pml4, page->va);
+		list_pop_front(&victim->pages);
+		page->frame = NULL;
+	}
+	victim->ref_cnt = 0;
 	lock_release(&frame_table_lock);
+
+	/* Futex waiters on the old contents would never be found
+	   again under this frame. */
+	futex_wake_page(victim->kva);
 	return victim;
 }
 
@@ -165,35 +312,78 @@ static struct frame *vm_get_frame(void)
 		return vm_evict_frame();
 
 	// frame 구조체를 생성한다
-	struct frame *frame = malloc(sizeof(*frame));
+	struct frame *frame = kmem_cache_alloc(&frame_kcache);
 	if (frame == NULL)
 		PANIC("(vm_get_frame)");
 
 	*frame = (struct frame){
-		.page = NULL,
 		.kva = kva,
+		.ref_cnt = 0,
 	};
+	list_init(&frame->pages);
 
-	ASSERT(frame->page == NULL);
+	ASSERT(frame->ref_cnt == 0);
 	return frame;
 }
 
 /* Growing the stack. */
-static bool vm_stack_growth(void *addr)
+static bool vm_stack_growth(void *addr, bool write)
 {
 	addr = pg_round_down(addr);
 	if (!vm_alloc_page(VM_ANON | VM_STACK_MAKER, addr, true))
 		return false;
 
-	if (!vm_claim_page(addr))
+	struct page *page = spt_find_page(&thread_current()->spt, addr);
+	if (page == NULL)
 		return false;
 
-	return true;
+	return vm_fault_in(page, write);
 }
 
-/* Handle the fault on write_protected page */
-static bool vm_handle_wp(struct page *page UNUSED)
+/* Handle the fault on write_protected page.
+ * PAGE is writable but mapped read-only because fork() shares its
+ * frame.  The last page left on the frame just takes it over;
+ * any other gets a private copy. */
+static bool vm_handle_wp(struct page *page)
 {
+	uint64_t *pml4 = thread_current()->pml4;
+	struct frame *frame, *copy;
+
+	lock_acquire(&frame_table_lock);
+	frame = page->frame;
+	if (frame != NULL && frame->ref_cnt == 1) {
+		pml4_clear_page(pml4, page->va);
+		pml4_set_page(pml4, page->va, frame->kva, true);
+		lock_release(&frame_table_lock);
+		return true;
+	}
+	lock_release(&frame_table_lock);
+
+	/* Evicted meanwhile: the retried access faults it back in. */
+	if (frame == NULL)
+		return true;
+
+	copy = vm_get_frame();
+	lock_acquire(&frame_table_lock);
+	if (page->frame != frame) {
+		/* vm_get_frame() evicted FRAME. */
+		lock_release(&frame_table_lock);
+		frame_free(copy);
+		return true;
+	}
+
+	memcpy(copy->kva, frame->kva, PGSIZE);
+	list_remove(&page->mapping_elem);
+	frame->ref_cnt--;
+	list_push_back(&copy->pages, &page->mapping_elem);
+	copy->ref_cnt = 1;
+	page->frame = copy;
+	list_push_back(&frame_list, &copy->frame_elem);
+
+	pml4_clear_page(pml4, page->va);
+	pml4_set_page(pml4, page->va, copy->kva, true);
+	lock_release(&frame_table_lock);
+	return true;
 }
 
 /* Return true on success */
@@ -201,6 +391,8 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 {
 	struct supplemental_page_table *spt = &thread_current()->spt;
 
+	fault_cnt++;
+
 	// 1. 유효성 검사
 	if (spt == NULL || addr < VM_BOTTOM || is_kernel_vaddr(addr))
 		return false;
@@ -217,7 +409,11 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 
 		// 페이지가 물리 메모리에 없는 경우 -> 프레임 할당 및 로드
 		if (not_present)
-			return vm_do_claim_page(page);
+			return vm_fault_in(page, write);
+
+		// fork로 공유 중인 프레임에 쓰기 -> copy-on-write
+		if (write)
+			return vm_handle_wp(page);
 
 		// 다른 종류의 fault (이론상 발생하지 않아야 함)
 		return false;
@@ -231,7 +427,7 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 		if (USER_STACK - (1 << 20) > addr || addr >= USER_STACK || addr < rsp - 8)
 			thread_exit();
 
-		return vm_stack_growth(addr);
+		return vm_stack_growth(addr, write);
 	}
 
 	// 기타 모든 경우 invalid access
@@ -243,7 +439,38 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 void vm_dealloc_page(struct page *page)
 {
 	destroy(page);
-	free(page);
+	kmem_cache_free(&page_kcache, page);
+}
+
+/* Prints VM statistics. */
+void vm_print_stats(void)
+{
+	printf("VM: %lld faults, %lld evictions (%lld clean)\n", fault_cnt, evict_cnt,
+		   evict_clean_cnt);
+	zswap_print_stats();
+}
+
+/* Drops PAGE's reference to its frame, if it still has one, and
+ * frees the frame and its physical page if no other page maps
+ * it. */
+void vm_release_frame(struct page *page)
+{
+	struct frame *frame;
+	bool last = false;
+
+	lock_acquire(&frame_table_lock);
+	frame = page->frame;
+	if (frame != NULL) {
+		list_remove(&page->mapping_elem);
+		last = --frame->ref_cnt == 0;
+		if (last)
+			frame_list_remove(frame);
+		page->frame = NULL;
+	}
+	lock_release(&frame_table_lock);
+
+	if (last)
+		frame_free(frame);
 }
 
 /* Claim the page that allocate on VA. */
@@ -266,21 +493,99 @@ static bool vm_do_claim_page(struct page *page)
 {
 	// 1. 물리 프레임을 할당한다 (프레임에 의미있는 데이터는 없는 상태)
 	struct frame *frame = vm_get_frame();
-	lock_acquire(&frame_table_lock);
-	list_push_back(&frame_list, &frame->frame_elem);
-	lock_release(&frame_table_lock);
 
 	// 2. 페이지와 프레임을 서로 연결한다
-	frame->page = page;
+	list_push_back(&frame->pages, &page->mapping_elem);
+	frame->ref_cnt = 1;
 	page->frame = frame;
 
-	// 3. pte 생성
+	// 3. 초기화 함수가 없는 anon 페이지는 eviction으로 재활용된 프레임의
+	//    이전 내용이 보이지 않도록 0으로 채운다
+	if (page_is_zero_fill(page))
+		memset(frame->kva, 0, PGSIZE);
+
+	// 4. pte 생성
 	bool success = pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable);
-	if (!success)
+
+	// 5. 페이지 초기화 (uninit_initialize)
+	if (!success || !swap_in(page, frame->kva)) {
+		pml4_clear_page(thread_current()->pml4, page->va);
+		list_remove(&page->mapping_elem);
+		frame->ref_cnt = 0;
+		page->frame = NULL;
+		frame_free(frame);
+		return false;
+	}
+
+	// 6. 내용이 채워진 뒤에야 eviction 대상이 되도록 frame table에 넣는다
+	lock_acquire(&frame_table_lock);
+	list_push_back(&frame_list, &frame->frame_elem);
+	lock_release(&frame_table_lock);
+	return true;
+}
+
+/* Brings in PAGE, which an access faulted on, for writing if
+ * WRITE is true. */
+static bool vm_fault_in(struct page *page, bool write)
+{
+	if (!write && vm_map_zero_page(page))
+		return true;
+	return vm_do_claim_page(page);
+}
+
+/* Returns true if PAGE is an anonymous page that has never held
+ * any data, that is, one without an initializer that is still
+ * waiting for its first fault, so that its contents are all
+ * zeros. */
+static bool page_is_zero_fill(struct page *page)
+{
+	return VM_TYPE(page->operations->type) == VM_UNINIT &&
+		   VM_TYPE(page->uninit.type) == VM_ANON && page->uninit.init == NULL &&
+		   page->uninit.aux == NULL;
+}
+
+/* If PAGE is a zero-fill page, maps the zero page at it read-only
+ * and returns true.  Otherwise returns false. */
+static bool vm_map_zero_page(struct page *page)
+{
+	if (!page_is_zero_fill(page))
+		return false;
+
+	/* Turns PAGE into an anonymous page without touching KVA. */
+	if (!swap_in(page, zero_frame.kva))
+		return false;
+	if (!pml4_set_page(thread_current()->pml4, page->va, zero_frame.kva, false))
 		return false;
 
-	// 4. 페이지 초기화 (uninit_initialize)
-	return swap_in(page, frame->kva);
+	lock_acquire(&frame_table_lock);
+	list_push_back(&zero_frame.pages, &page->mapping_elem);
+	zero_frame.ref_cnt++;
+	page->frame = &zero_frame;
+	lock_release(&frame_table_lock);
+	return true;
+}
+
+/* Maps the frame of SRC, a resident anonymous page of the parent,
+ * read-only into both the parent and DST, the uninitialized copy
+ * of SRC in the current (child) process.  Returns false, leaving
+ * DST untouched, if SRC is not resident. */
+static bool vm_share_frame(struct page *dst, struct page *src)
+{
+	struct frame *frame;
+	bool success = false;
+
+	lock_acquire(&frame_table_lock);
+	frame = src->frame;
+	if (frame != NULL && swap_in(dst, frame->kva) &&
+		pml4_set_page(thread_current()->pml4, dst->va, frame->kva, false)) {
+		pml4_set_page(src->owner_thread->pml4, src->va, frame->kva, false);
+		list_push_back(&frame->pages, &dst->mapping_elem);
+		frame->ref_cnt++;
+		dst->frame = frame;
+		success = true;
+	}
+	lock_release(&frame_table_lock);
+	return success;
 }
 
 // spt helpers
@@ -362,18 +667,22 @@ static void copy_page_from_spt(struct hash_elem *elem, void *aux)
 		case VM_UNINIT:
 			enum vm_type type = page_get_type(src_page);
 			if (src_page->uninit.type & VM_LOAD_MARKER) {
-				struct vm_load_aux *dst_aux = malloc(sizeof(*dst_aux));
+				struct vm_load_aux *dst_aux = vm_load_aux_alloc();
 				memcpy(dst_aux, src_page->uninit.aux, sizeof(*dst_aux));
 				vm_alloc_page_with_initializer(type, va, writable, src_page->uninit.init, dst_aux);
 				return;
 			}
 
 			if (type == VM_FILE) {
-				struct mmap_aux *dst_aux = malloc(sizeof(*dst_aux));
+				struct mmap_aux *dst_aux = mmap_aux_alloc();
 				memcpy(dst_aux, src_page->uninit.aux, sizeof(*dst_aux));
 				vm_alloc_page_with_initializer(type, va, writable, src_page->uninit.init, dst_aux);
 				return;
 			}
+
+			// 아직 한 번도 접근하지 않은 zero-fill anon 페이지
+			if (type == VM_ANON && src_page->uninit.init == NULL)
+				vm_alloc_page(src_page->uninit.type, va, writable);
 			return;
 		case VM_FILE:
 			vm_alloc_page_with_initializer(VM_FILE, va, writable, NULL, &src_page->file);
@@ -389,6 +698,10 @@ static void copy_page_from_spt(struct hash_elem *elem, void *aux)
 	if (dst_page == NULL)
 		PANIC("copy_page_from_spt: dst_page not found.");
 
+	// anon 페이지는 복사하지 않고 프레임을 공유한다 (copy-on-write)
+	if (VM_TYPE(src_page->operations->type) == VM_ANON && vm_share_frame(dst_page, src_page))
+		return;
+
 	// 프레임 즉시 할당
 	if (!vm_do_claim_page(dst_page))
 		return;
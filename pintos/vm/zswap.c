@@ -0,0 +1,180 @@
+/* zswap.c: Compressed cache of swapped-out anonymous pages. */
+
+#include "vm/zswap.h"
+#include <debug.h>
+#include <list.h>
+#include <lz.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+/* Anonymous pages on their way to the swap disk are compressed
+   and kept in kernel memory instead, as long as they shrink to
+   ZSWAP_MAX_LEN bytes and the cache, counting each entry's
+   header, stays within zswap_page_limit pages.  Pintos gives user pages and kernel
+   pages separate pools, so the cache holds memory that eviction
+   could not have used anyway.  To make room for a new page, the
+   least recently stored pages are decompressed and written to
+   the swap disk; if the disk is full, the new page is rejected
+   instead, so the cache never grows past its limit.  Loading a
+   page from the cache removes it.
+
+   zswap_lock protects the cache, the anon.zswap member of each
+   page in it, and the buffers below.  A spill gives a page in the
+   cache a swap slot under zswap_lock, so the slot of a page that
+   may be in the cache must be read with the lock held, after
+   dropping the page from the cache, as zswap_invalidate() does.
+   The lock is taken after the frame table lock on the eviction
+   path and never the other way around. */
+
+/* A compressed page. */
+struct zswap_entry {
+	struct list_elem lru_elem; /* Element in zswap_lru. */
+	struct page *page;		   /* Page stored. */
+	size_t len;				   /* Size of DATA in bytes. */
+	uint8_t data[];			   /* Compressed contents. */
+};
+
+/* Largest compressed page kept, so that an entry fits in the
+   largest malloc() block that does not take a whole page.
+   Anything bigger is not worth the memory. */
+#define ZSWAP_MAX_LEN (PGSIZE * 3 / 8 - sizeof(struct zswap_entry))
+
+size_t zswap_page_limit = 256;
+
+static struct list zswap_lru; /* Entries, least recently stored first. */
+static size_t zswap_bytes;	  /* Bytes of entries cached. */
+static struct lock zswap_lock;
+
+static uint8_t lz_work[LZ_WORK_SIZE]; /* Compressor scratch space. */
+static uint8_t zbuf[ZSWAP_MAX_LEN];	  /* Compression output. */
+static uint8_t spill_buf[PGSIZE];	  /* Decompressed page being spilled. */
+
+/* Statistics. */
+static long long store_cnt;	 /* # of pages stored. */
+static long long reject_cnt; /* # of pages not stored. */
+static long long load_cnt;	 /* # of pages loaded back. */
+static long long spill_cnt;	 /* # of pages spilled to disk. */
+
+static void zswap_remove(struct zswap_entry *e);
+static bool zswap_shrink(size_t size);
+
+/* Initializes the compressed cache. */
+void zswap_init(void)
+{
+	list_init(&zswap_lru);
+	lock_init(&zswap_lock);
+}
+
+/* Tries to store the contents of anonymous page PAGE, at KVA, in
+   the cache.  Returns true if successful, false if the page
+   should go to the swap disk instead. */
+bool zswap_store(struct page *page, const void *kva)
+{
+	struct zswap_entry *e;
+	size_t len;
+
+	ASSERT(page->anon.zswap == NULL);
+
+	if (zswap_page_limit == 0)
+		return false;
+
+	lock_acquire(&zswap_lock);
+	len = lz_compress(kva, PGSIZE, zbuf, sizeof zbuf, lz_work);
+	e = len != 0 && zswap_shrink(sizeof *e + len) ? malloc(sizeof *e + len) : NULL;
+	if (e == NULL) {
+		reject_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+
+	e->page = page;
+	e->len = len;
+	memcpy(e->data, zbuf, len);
+	list_push_back(&zswap_lru, &e->lru_elem);
+	zswap_bytes += sizeof *e + len;
+	page->anon.zswap = e;
+	store_cnt++;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* If PAGE is in the cache, decompresses it into KVA, drops it
+   from the cache, and returns true.  Otherwise returns false. */
+bool zswap_load(struct page *page, void *kva)
+{
+	struct zswap_entry *e;
+
+	lock_acquire(&zswap_lock);
+	e = page->anon.zswap;
+	if (e == NULL) {
+		lock_release(&zswap_lock);
+		return false;
+	}
+
+	if (lz_decompress(e->data, e->len, kva, PGSIZE) != PGSIZE)
+		PANIC("zswap: corrupt page at %p", page->va);
+	zswap_remove(e);
+	load_cnt++;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* Drops PAGE from the cache, if it is there, and returns its swap
+   slot, which a spill may have just set, or BITMAP_ERROR if it has
+   none.  PAGE must already have released its frame, so that no
+   eviction can store it in the cache or give it a slot
+   afterward. */
+size_t zswap_invalidate(struct page *page)
+{
+	size_t slot;
+
+	lock_acquire(&zswap_lock);
+	if (page->anon.zswap != NULL)
+		zswap_remove(page->anon.zswap);
+	slot = page->anon.swap_table_index;
+	lock_release(&zswap_lock);
+	return slot;
+}
+
+/* Prints compressed cache statistics. */
+void zswap_print_stats(void)
+{
+	printf("zswap: %lld stored, %lld rejected, %lld loaded, %lld spilled\n", store_cnt,
+		   reject_cnt, load_cnt, spill_cnt);
+}
+
+/* Removes E from the cache and frees it. */
+static void zswap_remove(struct zswap_entry *e)
+{
+	ASSERT(lock_held_by_current_thread(&zswap_lock));
+
+	list_remove(&e->lru_elem);
+	zswap_bytes -= sizeof *e + e->len;
+	e->page->anon.zswap = NULL;
+	free(e);
+}
+
+/* Writes the least recently stored pages to the swap disk until
+   an entry of SIZE bytes fits within the limit of the cache.  Returns false
+   if the disk fills up first. */
+static bool zswap_shrink(size_t size)
+{
+	ASSERT(size <= zswap_page_limit * PGSIZE);
+
+	while (zswap_bytes + size > zswap_page_limit * PGSIZE) {
+		struct zswap_entry *e = list_entry(list_front(&zswap_lru), struct zswap_entry, lru_elem);
+		struct page *page = e->page;
+
+		lz_decompress(e->data, e->len, spill_buf, PGSIZE);
+		if (!anon_swap_write(page, spill_buf))
+			return false;
+		zswap_remove(e);
+		spill_cnt++;
+	}
+	return true;
+}